@@ -0,0 +1,86 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+#include "Calculus/exprcalculator.h"
+
+#define ITERATIONS 2000000
+
+/* Evaluates a few parametric equations, the way ParEqWidget animates them, first through the
+   bytecode interpreter then through the code generated by JitCompiler, and prints both timings. */
+
+static double run(ExprCalculator &calculator, const ByteCode &code)
+{
+    double outputs[2], sum = 0;
+
+    for(int i = 0 ; i < ITERATIONS ; i++)
+    {
+        calculator.calculateOutputsFromByteCode(code, i * 0.00001, outputs);
+        sum += outputs[0] + outputs[1];
+    }
+
+    return sum;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QList<QStringList> equations;
+    equations << (QStringList() << "t*cos(t)" << "t*sin(t)")
+              << (QStringList() << "cos(3t)*(1+0.5cos(20t))+k*t^2" << "sin(2t)*(1+0.5cos(20t))")
+              << (QStringList() << "(1+k)*t^3-2t^2+t-1" << "(t-k)/(1+t^2)+t^4");
+
+    TreeCreator treeCreator(PARAMETRIC_EQ);
+    ExprCalculator calculator(true);
+    calculator.setK(0.5);
+
+    for(int i = 0 ; i < equations.size() ; i++)
+    {
+        bool ok = true;
+        ByteCode code = treeCreator.getByteCodeFromExprs(equations[i], ok);
+
+        if(!ok)
+            continue;
+
+        ByteCode interpreted = code;
+        interpreted.native = NULL;
+
+        QElapsedTimer timer;
+
+        timer.start();
+        double interpretedSum = run(calculator, interpreted);
+        qint64 interpretedTime = timer.elapsed();
+
+        timer.restart();
+        double nativeSum = run(calculator, code);
+        qint64 nativeTime = timer.elapsed();
+
+        out << equations[i].join(" ; ") << endl;
+        out << "    interpreter: " << interpretedTime << " ms, jit: " << nativeTime << " ms"
+            << (code.native == NULL ? " (not compiled)" : "")
+            << (interpretedSum == nativeSum ? "" : " RESULTS DIFFER") << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,42 @@
+#-------------------------------------------------
+#
+# Compares the expression JIT with the bytecode interpreter
+#
+#-------------------------------------------------
+
+
+QT += widgets
+
+TARGET = jitbenchmark
+TEMPLATE = app
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += ZEGRAPHER_JIT
+
+OBJECTS_DIR = .obj
+MOC_DIR = .moc
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    jitbenchmark.cpp \
+    ../Calculus/treecreator.cpp \
+    ../Calculus/bytecodeevaluator.cpp \
+    ../Calculus/jitcompiler.cpp \
+    ../Calculus/exprcalculator.cpp \
+    ../Calculus/funccalculator.cpp \
+    ../Calculus/valuescache.cpp \
+    ../Calculus/colorsaver.cpp \
+    ../GraphDraw/graphview.cpp
+
+HEADERS += \
+    ../Calculus/treecreator.h \
+    ../Calculus/bytecodeevaluator.h \
+    ../Calculus/jitcompiler.h \
+    ../Calculus/exprcalculator.h \
+    ../Calculus/funccalculator.h \
+    ../Calculus/valuescache.h \
+    ../Calculus/colorsaver.h \
+    ../GraphDraw/graphview.h \
+    ../structures.h
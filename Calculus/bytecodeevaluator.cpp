@@ -0,0 +1,480 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+#include "Calculus/bytecodeevaluator.h"
+
+static double tenPower(double x)
+{
+     return pow(10, x);
+}
+
+//same order as TreeCreator::refFunctions, tenPower must figure two times for e and E
+static double (* const refFuncs[])(double) = { acos, asin, atan, cos, sin, tan, sqrt,
+                                                log10, log, fabs, exp, floor, ceil, cosh,
+                                                sinh, tanh, tenPower, tenPower, acosh, asinh,
+                                                atanh, erf, erfc, tgamma, tgamma, cosh,
+                                                sinh, tanh, acosh, asinh, atanh };
+
+static double digamma(double x)
+{
+    if(x <= 0 && x == floor(x))
+        return NAN;
+
+    if(x < 0) // reflection formula
+        return digamma(1 - x) - M_PI/tan(M_PI*x);
+
+    double result = 0;
+
+    for( ; x < 6 ; x++)
+        result -= 1/x;
+
+    double inv2 = 1/(x*x);
+
+    return result + log(x) - 0.5/x - inv2*(1.0/12 - inv2*(1.0/120 - inv2/252));
+}
+
+static double acosDerivative(double x) { return -1/sqrt(1 - x*x); }
+static double asinDerivative(double x) { return 1/sqrt(1 - x*x); }
+static double atanDerivative(double x) { return 1/(1 + x*x); }
+static double cosDerivative(double x) { return -sin(x); }
+static double tanDerivative(double x) { double t = tan(x); return 1 + t*t; }
+static double sqrtDerivative(double x) { return 0.5/sqrt(x); }
+static double log10Derivative(double x) { return 1/(x*M_LN10); }
+static double logDerivative(double x) { return 1/x; }
+static double fabsDerivative(double x) { return (x > 0) - (x < 0); }
+static double nullDerivative(double x) { Q_UNUSED(x); return 0; }
+static double tanhDerivative(double x) { double t = tanh(x); return 1 - t*t; }
+static double tenPowerDerivative(double x) { return M_LN10*pow(10, x); }
+static double acoshDerivative(double x) { return 1/sqrt(x*x - 1); }
+static double asinhDerivative(double x) { return 1/sqrt(x*x + 1); }
+static double atanhDerivative(double x) { return 1/(1 - x*x); }
+static double erfDerivative(double x) { return M_2_SQRTPI*exp(-x*x); }
+static double erfcDerivative(double x) { return -M_2_SQRTPI*exp(-x*x); }
+static double tgammaDerivative(double x) { return tgamma(x)*digamma(x); }
+
+//derivatives of refFuncs, in the same order
+static double (* const refFuncsDerivatives[])(double) = { acosDerivative, asinDerivative, atanDerivative, cosDerivative,
+                                                           cos, tanDerivative, sqrtDerivative, log10Derivative,
+                                                           logDerivative, fabsDerivative, exp, nullDerivative,
+                                                           nullDerivative, sinh, cosh, tanhDerivative,
+                                                           tenPowerDerivative, tenPowerDerivative, acoshDerivative,
+                                                           asinhDerivative, atanhDerivative, erfDerivative,
+                                                           erfcDerivative, tgammaDerivative, tgammaDerivative,
+                                                           sinh, cosh, tanhDerivative, acoshDerivative,
+                                                           asinhDerivative, atanhDerivative };
+
+ByteCodeEvaluator::ByteCodeEvaluator()
+{
+}
+
+ByteCodeEvaluator::~ByteCodeEvaluator()
+{
+}
+
+double ByteCodeEvaluator::callRefFunc(short type, double arg)
+{
+    return (*refFuncs[type - REF_FUNC_START - 1])(arg);
+}
+
+RefFunc ByteCodeEvaluator::getRefFunc(short type)
+{
+    return refFuncs[type - REF_FUNC_START - 1];
+}
+
+double ByteCodeEvaluator::callMathObject(short type, double arg, double k, bool &ok)
+{
+    Q_UNUSED(type);
+    Q_UNUSED(arg);
+    Q_UNUSED(k);
+    Q_UNUSED(ok);
+
+    return NAN;
+}
+
+void ByteCodeEvaluator::callMathObjectOnArray(short type, const double *args, double *results, int n, double k, bool &ok)
+{
+    for(int i = 0 ; i < n && ok ; i++)
+        results[i] = callMathObject(type, args[i], k, ok);
+}
+
+double ByteCodeEvaluator::callMathObjectDerivative(short type, double arg, double k, bool &ok)
+{
+    Q_UNUSED(type);
+    Q_UNUSED(arg);
+    Q_UNUSED(k);
+    Q_UNUSED(ok);
+
+    return NAN;
+}
+
+double ByteCodeEvaluator::getAdditionnalVarValue(int index)
+{
+    Q_UNUSED(index);
+
+    return NAN;
+}
+
+void ByteCodeEvaluator::getAdditionnalVarValues(int index, int first, double *values, int n)
+{
+    Q_UNUSED(first);
+
+    double value = getAdditionnalVarValue(index);
+
+    for(int i = 0 ; i < n ; i++)
+        values[i] = value;
+}
+
+double ByteCodeEvaluator::evaluateByteCode(const ByteCode &code, double var, double k, bool &ok)
+{
+    if(code.instructions.isEmpty())
+        return NAN;
+
+    if(code.native != NULL)
+    {
+        QVarLengthArray<double, 32> values(code.stackSize + code.tempsCount);
+        code.native(values.data(), var, k);
+        return values[0];
+    }
+
+    QVarLengthArray<double, 32> stack(code.stackSize);
+    evaluateStack(code, var, k, ok, stack.data());
+
+    if(!ok)
+        return NAN;
+
+    return stack[0];
+}
+
+void ByteCodeEvaluator::evaluateByteCode(const ByteCode &code, double var, double k, bool &ok, double *outputs)
+{
+    if(code.instructions.isEmpty())
+        ok = false;
+
+    QVarLengthArray<double, 32> stack(code.stackSize + code.tempsCount);
+
+    if(ok && code.native != NULL)
+        code.native(stack.data(), var, k);
+    else if(ok)
+        evaluateStack(code, var, k, ok, stack.data());
+
+    for(int i = 0 ; i < code.outputsCount ; i++)
+        outputs[i] = ok ? stack[i] : NAN;
+}
+
+double ByteCodeEvaluator::evaluateDualByteCode(const ByteCode &code, double var, double k, bool &ok, double &derivative)
+{
+    /* Forward mode automatic differentiation: every stack slot holds a value and its derivative
+       with respect to the variable, both carried through each instruction by the chain rule. */
+
+    derivative = NAN;
+
+    if(code.instructions.isEmpty())
+        return NAN;
+
+    QVarLengthArray<double, 32> values(code.stackSize), derivatives(code.stackSize);
+    QVarLengthArray<double, 16> tempValues(code.tempsCount), tempDerivatives(code.tempsCount);
+    double *top = values.data() - 1, *dtop = derivatives.data() - 1;
+    double a, da, b, db;
+
+    const ByteCodeInstr *instr = code.instructions.constData();
+    const ByteCodeInstr *end = instr + code.instructions.size();
+
+    for( ; instr != end ; instr++)
+    {
+        switch(instr->type)
+        {
+        case NUMBER:
+            *(++top) = instr->value;
+            *(++dtop) = 0;
+            break;
+        case VAR_X:
+        case VAR_T:
+        case VAR_N:
+            *(++top) = var;
+            *(++dtop) = 1;
+            break;
+        case PAR_K:
+            *(++top) = k;
+            *(++dtop) = 0;
+            break;
+        case PLUS:
+            top--; dtop--;
+            *top += top[1];
+            *dtop += dtop[1];
+            break;
+        case MINUS:
+            top--; dtop--;
+            *top -= top[1];
+            *dtop -= dtop[1];
+            break;
+        case MULTIPLY:
+            top--; dtop--;
+            *dtop = *dtop * top[1] + *top * dtop[1];
+            *top *= top[1];
+            break;
+        case DIVIDE:
+            top--; dtop--;
+            *dtop = (*dtop * top[1] - *top * dtop[1]) / (top[1] * top[1]);
+            *top /= top[1];
+            break;
+        case POW:
+            top--; dtop--;
+            a = *top; da = *dtop; b = top[1]; db = dtop[1];
+            *top = pow(a, b);
+            *dtop = 0;
+            if(da != 0) // written apart so that constant exponents keep negative bases valid
+                *dtop += b * pow(a, b - 1) * da;
+            if(db != 0)
+                *dtop += *top * log(a) * db;
+            break;
+        case SQUARE:
+            *dtop *= 2 * *top;
+            *top *= *top;
+            break;
+        case CUBE:
+            *dtop *= 3 * *top * *top;
+            *top *= *top * *top;
+            break;
+        case STORE_TMP:
+            tempValues[int(instr->value)] = *top;
+            tempDerivatives[int(instr->value)] = *dtop;
+            break;
+        case LOAD_TMP:
+            *(++top) = tempValues[int(instr->value)];
+            *(++dtop) = tempDerivatives[int(instr->value)];
+            break;
+        default:
+            if(REF_FUNC_START < instr->type && instr->type < REF_FUNC_END)
+            {
+                if(*dtop != 0)
+                    *dtop *= (*refFuncsDerivatives[instr->type - REF_FUNC_START - 1])(*top);
+                *top = (*refFuncs[instr->type - REF_FUNC_START - 1])(*top);
+            }
+            else if(instr->type >= ADDITIONNAL_VARS_START)
+            {
+                *(++top) = getAdditionnalVarValue(instr->type - ADDITIONNAL_VARS_START);
+                *(++dtop) = 0;
+            }
+            else
+            {
+                if(*dtop != 0)
+                    *dtop *= callMathObjectDerivative(instr->type, *top, k, ok);
+                if(ok)
+                    *top = callMathObject(instr->type, *top, k, ok);
+                if(!ok)
+                    return NAN;
+            }
+        }
+    }
+
+    derivative = derivatives[0];
+    return values[0];
+}
+
+void ByteCodeEvaluator::evaluateStack(const ByteCode &code, double var, double k, bool &ok, double *stack)
+{
+    QVarLengthArray<double, 16> temps(code.tempsCount);
+    double *top = stack - 1;
+
+    const ByteCodeInstr *instr = code.instructions.constData();
+    const ByteCodeInstr *end = instr + code.instructions.size();
+
+    for( ; instr != end ; instr++)
+    {
+        switch(instr->type)
+        {
+        case NUMBER:
+            *(++top) = instr->value;
+            break;
+        case VAR_X:
+        case VAR_T:
+        case VAR_N:
+            *(++top) = var;
+            break;
+        case PAR_K:
+            *(++top) = k;
+            break;
+        case PLUS:
+            top--;
+            *top += top[1];
+            break;
+        case MINUS:
+            top--;
+            *top -= top[1];
+            break;
+        case MULTIPLY:
+            top--;
+            *top *= top[1];
+            break;
+        case DIVIDE:
+            top--;
+            *top /= top[1];
+            break;
+        case POW:
+            top--;
+            *top = pow(*top, top[1]);
+            break;
+        case SQUARE:
+            *top *= *top;
+            break;
+        case CUBE:
+            *top *= *top * *top;
+            break;
+        case STORE_TMP:
+            temps[int(instr->value)] = *top;
+            break;
+        case LOAD_TMP:
+            *(++top) = temps[int(instr->value)];
+            break;
+        default:
+            if(REF_FUNC_START < instr->type && instr->type < REF_FUNC_END)
+                *top = (*refFuncs[instr->type - REF_FUNC_START - 1])(*top);
+            else if(instr->type >= ADDITIONNAL_VARS_START)
+                *(++top) = getAdditionnalVarValue(instr->type - ADDITIONNAL_VARS_START);
+            else
+            {
+                *top = callMathObject(instr->type, *top, k, ok);
+                if(!ok)
+                    return;
+            }
+        }
+    }
+}
+
+void ByteCodeEvaluator::evaluateByteCode(const ByteCode &code, const double *vars, double *results, int n, double k, bool &ok, int first)
+{
+    if(code.instructions.isEmpty())
+        ok = false;
+
+    QVarLengthArray<double, 8*BATCH_SIZE> stack(code.stackSize * BATCH_SIZE);
+    QVarLengthArray<double, 4*BATCH_SIZE> temps(code.tempsCount * BATCH_SIZE);
+    int start = 0, size;
+
+    for( ; start < n && ok ; start += BATCH_SIZE)
+    {
+        size = qMin(BATCH_SIZE, n - start);
+        evaluateBatch(code, vars + start, stack.data(), temps.data(), size, k, ok, first + start);
+
+        if(ok)
+            memcpy(results + start, stack.data(), size * sizeof(double)); // the result is left in the bottom slot
+    }
+
+    if(!ok)
+    {
+        for(start = 0 ; start < n ; start++)
+            results[start] = NAN;
+    }
+}
+
+void ByteCodeEvaluator::evaluateBatch(const ByteCode &code, const double *vars, double *stack, double *temps, int n, double k, bool &ok, int first)
+{
+    double *top = stack - BATCH_SIZE, *operand;
+    double value;
+    int i;
+
+    const ByteCodeInstr *instr = code.instructions.constData();
+    const ByteCodeInstr *end = instr + code.instructions.size();
+
+    for( ; instr != end ; instr++)
+    {
+        operand = top;
+
+        switch(instr->type)
+        {
+        case NUMBER:
+            top += BATCH_SIZE;
+            value = instr->value;
+            for(i = 0 ; i < n ; i++)
+                top[i] = value;
+            break;
+        case VAR_X:
+        case VAR_T:
+        case VAR_N:
+            top += BATCH_SIZE;
+            memcpy(top, vars, n * sizeof(double));
+            break;
+        case PAR_K:
+            top += BATCH_SIZE;
+            for(i = 0 ; i < n ; i++)
+                top[i] = k;
+            break;
+        case PLUS:
+            top -= BATCH_SIZE;
+            for(i = 0 ; i < n ; i++)
+                top[i] += operand[i];
+            break;
+        case MINUS:
+            top -= BATCH_SIZE;
+            for(i = 0 ; i < n ; i++)
+                top[i] -= operand[i];
+            break;
+        case MULTIPLY:
+            top -= BATCH_SIZE;
+            for(i = 0 ; i < n ; i++)
+                top[i] *= operand[i];
+            break;
+        case DIVIDE:
+            top -= BATCH_SIZE;
+            for(i = 0 ; i < n ; i++)
+                top[i] /= operand[i];
+            break;
+        case POW:
+            top -= BATCH_SIZE;
+            for(i = 0 ; i < n ; i++)
+                top[i] = pow(top[i], operand[i]);
+            break;
+        case SQUARE:
+            for(i = 0 ; i < n ; i++)
+                top[i] *= top[i];
+            break;
+        case CUBE:
+            for(i = 0 ; i < n ; i++)
+                top[i] *= top[i] * top[i];
+            break;
+        case STORE_TMP:
+            memcpy(temps + int(instr->value) * BATCH_SIZE, top, n * sizeof(double));
+            break;
+        case LOAD_TMP:
+            top += BATCH_SIZE;
+            memcpy(top, temps + int(instr->value) * BATCH_SIZE, n * sizeof(double));
+            break;
+        default:
+            if(REF_FUNC_START < instr->type && instr->type < REF_FUNC_END)
+            {
+                double (*refFunc)(double) = refFuncs[instr->type - REF_FUNC_START - 1];
+                for(i = 0 ; i < n ; i++)
+                    top[i] = (*refFunc)(top[i]);
+            }
+            else if(instr->type >= ADDITIONNAL_VARS_START)
+            {
+                top += BATCH_SIZE;
+                getAdditionnalVarValues(instr->type - ADDITIONNAL_VARS_START, first, top, n);
+            }
+            else
+            {
+                callMathObjectOnArray(instr->type, top, top, n, k, ok);
+                if(!ok)
+                    return;
+            }
+        }
+    }
+}
@@ -0,0 +1,69 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+#ifndef BYTECODEEVALUATOR_H
+#define BYTECODEEVALUATOR_H
+
+#include "structures.h"
+#include "calculusdefines.h"
+
+#define BATCH_SIZE 256 // number of samples every instruction processes at once in the array evaluation
+
+/* Stack machine that runs the postfix programs compiled by TreeCreator.
+   Calls to other math objects (f(x), f'(x), F(x), u(n)...) are forwarded to callMathObject(),
+   which every calculator reimplements according to what its expressions can call.
+   The array variant evaluates a whole vector of samples instruction by instruction, each stack slot
+   holding BATCH_SIZE values, so the arithmetic runs in tight loops the compiler can vectorize.
+   There, additionnal variables can differ from a sample to the other: "first" is the index of the
+   first sample, getAdditionnalVarValues() is given to fill a slot with the values of the next ones.
+   Programs compiled from several trees leave one output per tree at the bottom of the stack.
+   The dual variant returns the derivative along with the value, in a single pass. */
+
+typedef double (*RefFunc)(double);
+
+class ByteCodeEvaluator
+{
+public:
+    ByteCodeEvaluator();
+    virtual ~ByteCodeEvaluator();
+
+    static double callRefFunc(short type, double arg);
+    static RefFunc getRefFunc(short type);
+
+protected:
+    double evaluateByteCode(const ByteCode &code, double var, double k, bool &ok);
+    void evaluateByteCode(const ByteCode &code, double var, double k, bool &ok, double *outputs);
+    void evaluateByteCode(const ByteCode &code, const double *vars, double *results, int n, double k, bool &ok, int first = 0);
+    double evaluateDualByteCode(const ByteCode &code, double var, double k, bool &ok, double &derivative);
+
+    virtual double callMathObject(short type, double arg, double k, bool &ok);
+    virtual void callMathObjectOnArray(short type, const double *args, double *results, int n, double k, bool &ok);
+    virtual double callMathObjectDerivative(short type, double arg, double k, bool &ok);
+    virtual double getAdditionnalVarValue(int index);
+    virtual void getAdditionnalVarValues(int index, int first, double *values, int n);
+
+    void evaluateStack(const ByteCode &code, double var, double k, bool &ok, double *stack);
+    void evaluateBatch(const ByteCode &code, const double *vars, double *stack, double *temps, int n, double k, bool &ok, int first);
+};
+
+#endif // BYTECODEEVALUATOR_H
@@ -47,6 +47,12 @@ enum {
     MULTIPLY ,
     DIVIDE ,
 
+    SQUARE , // x^2 and x^3 rewritten by TreeCreator::simplifyFastTree
+    CUBE ,
+
+    STORE_TMP , // bytecode only: common subexpressions saved and reloaded
+    LOAD_TMP ,
+
     SEQUENCES_START ,
 
     SEQ_U ,
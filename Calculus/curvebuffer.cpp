@@ -0,0 +1,198 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#include "Calculus/curvebuffer.h"
+
+CurveBuffer::CurveBuffer()
+{
+    head = count = 0;
+}
+
+int CurveBuffer::size() const
+{
+    return count;
+}
+
+bool CurveBuffer::isEmpty() const
+{
+    return count == 0;
+}
+
+void CurveBuffer::clear()
+{
+    head = count = 0;
+}
+
+int CurveBuffer::index(int i) const
+{
+    return (head + i) & (points.size() - 1);
+}
+
+void CurveBuffer::grow()
+{
+    int capacity = qMax(16, points.size() * 2);
+
+    QVector<QPointF> newPoints(capacity);
+    QBitArray newBreaks(capacity);
+
+    for(int i = 0 ; i < count ; i++)
+    {
+        newPoints[i] = points[index(i)];
+        newBreaks.setBit(i, breaks.testBit(index(i)));
+    }
+
+    points = newPoints;
+    breaks = newBreaks;
+    head = 0;
+}
+
+const QPointF& CurveBuffer::at(int i) const
+{
+    return points[index(i)];
+}
+
+const QPointF& CurveBuffer::first() const
+{
+    return points[head];
+}
+
+const QPointF& CurveBuffer::last() const
+{
+    return points[index(count - 1)];
+}
+
+bool CurveBuffer::isBreak(int i) const
+{
+    return i > 0 && breaks.testBit(index(i));
+}
+
+int CurveBuffer::lowerBound(double x) const
+{
+    int low = 0, high = count, middle;
+
+    while(low < high)
+    {
+        middle = (low + high) / 2;
+
+        if(at(middle).x() < x)
+            low = middle + 1;
+        else high = middle;
+    }
+
+    return low;
+}
+
+double CurveBuffer::distanceTo(const QPointF &pt, double xUnit, double yUnit, double radius) const
+{
+    double distance = INFINITY;
+
+    // only the segments that start or end less than radius pixels away horizontally can be closer
+    int start = qMax(lowerBound(pt.x() - radius / xUnit) - 1, 0);
+    int end = qMin(lowerBound(pt.x() + radius / xUnit) + 1, count);
+
+    for(int i = start ; i < end ; i++)
+    {
+        QPointF a((at(i).x() - pt.x()) * xUnit, (at(i).y() - pt.y()) * yUnit);
+        double squaredDistance = a.x() * a.x() + a.y() * a.y();
+
+        if(i + 1 < count && !isBreak(i + 1))
+        {
+            QPointF ab((at(i + 1).x() - at(i).x()) * xUnit, (at(i + 1).y() - at(i).y()) * yUnit);
+            double squaredLength = ab.x() * ab.x() + ab.y() * ab.y();
+
+            if(squaredLength > 0)
+            {
+                double t = qBound(0.0, - (a.x() * ab.x() + a.y() * ab.y()) / squaredLength, 1.0);
+                QPointF closest = a + t * ab;
+                squaredDistance = closest.x() * closest.x() + closest.y() * closest.y();
+            }
+        }
+
+        distance = qMin(distance, sqrt(squaredDistance));
+    }
+
+    return distance < radius ? distance : INFINITY;
+}
+
+void CurveBuffer::setBreak(int i)
+{
+    breaks.setBit(index(i));
+}
+
+void CurveBuffer::append(const QPointF &pt, bool newPart)
+{
+    if(count == points.size())
+        grow();
+
+    points[index(count)] = pt;
+    breaks.setBit(index(count), newPart);
+    count++;
+}
+
+void CurveBuffer::prepend(const QPointF &pt, bool newPart)
+{
+    if(count == points.size())
+        grow();
+
+    if(count > 0)
+        breaks.setBit(head, newPart);
+
+    head = (head - 1) & (points.size() - 1);
+    points[head] = pt;
+    breaks.clearBit(head);
+    count++;
+}
+
+void CurveBuffer::removeFirst()
+{
+    head = index(1);
+    count--;
+}
+
+void CurveBuffer::removeLast()
+{
+    count--;
+}
+
+QList<QPolygonF> CurveBuffer::toPolygons() const
+{
+    QList<QPolygonF> parts;
+    QPolygonF part;
+
+    for(int i = 0 ; i < count ; i++)
+    {
+        if(isBreak(i))
+        {
+            parts << part;
+            part.clear();
+        }
+
+        part << at(i);
+    }
+
+    if(!part.isEmpty())
+        parts << part;
+
+    return parts;
+}
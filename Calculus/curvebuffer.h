@@ -0,0 +1,67 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#ifndef CURVEBUFFER_H
+#define CURVEBUFFER_H
+
+#include "structures.h"
+
+/* Points of a curve, kept in a circular buffer so that points can be added and dropped at both
+   ends in constant time when the view is moved. The curve may be made of several parts: a set bit
+   in "breaks" means that no segment links a point to the previous one. */
+
+class CurveBuffer
+{
+public:
+    CurveBuffer();
+
+    int size() const;
+    bool isEmpty() const;
+    void clear();
+
+    const QPointF& at(int i) const;
+    const QPointF& first() const;
+    const QPointF& last() const;
+    bool isBreak(int i) const; // whether the point i starts a new part
+    int lowerBound(double x) const; // first point whose abscissa isn't less than x, abscissas are increasing
+    double distanceTo(const QPointF &pt, double xUnit, double yUnit, double radius) const; // in pixels, INFINITY beyond radius
+    void setBreak(int i);
+
+    void append(const QPointF &pt, bool newPart = false);
+    void prepend(const QPointF &pt, bool newPart = false); // newPart: no segment to the current first point
+    void removeFirst();
+    void removeLast();
+
+    QList<QPolygonF> toPolygons() const;
+
+protected:
+    int index(int i) const;
+    void grow();
+
+    QVector<QPointF> points; // capacity is a power of two
+    QBitArray breaks;
+    int head, count;
+};
+
+#endif // CURVEBUFFER_H
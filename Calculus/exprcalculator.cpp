@@ -20,18 +20,11 @@
 
 #include "Calculus/exprcalculator.h"
 
-static double tenPower(double x)
-{
-     return pow(10, x);
-}
-
 ExprCalculator::ExprCalculator(bool allowK, QList<FuncCalculator *> otherFuncs) : treeCreator(NORMAL_EXPR)
 {    
     treeCreator.allow_k(allowK);
     k = 0;
-    currentTree = NULL;
     funcCalculatorsList = otherFuncs;
-    addRefFuncsPointers();
 }
 
 double ExprCalculator::calculateExpression(QString expr, bool &ok, double k_val)
@@ -43,16 +36,12 @@ double ExprCalculator::calculateExpression(QString expr, bool &ok, double k_val)
     if(!ok)
         return NAN;
 
-    currentTree = treeCreator.getTreeFromExpr(expr, ok);
+    ByteCode code = treeCreator.getByteCodeFromExpr(expr, ok);
 
     if(!ok)
         return NAN;
 
-    double result = calculateFromTree(currentTree);
-    treeCreator.deleteFastTree(currentTree);
-    currentTree = NULL;
-
-    return result;
+    return calculateFromByteCode(code);
 }
 
 void ExprCalculator::setAdditionnalVarsValues(QList<double> values)
@@ -60,6 +49,11 @@ void ExprCalculator::setAdditionnalVarsValues(QList<double> values)
     additionnalVarsValues = values;
 }
 
+void ExprCalculator::setAdditionnalVarsColumns(QList<const double*> columns)
+{
+    additionnalVarsColumns = columns;
+}
+
 void ExprCalculator::setK(double val)
 {
     k = val;
@@ -86,67 +80,51 @@ bool ExprCalculator::checkCalledFuncsValidity(QString expr)
     return false;
 }
 
-void ExprCalculator::addRefFuncsPointers()
+double ExprCalculator::calculateFromByteCode(const ByteCode &code, double x)
 {
-    refFuncs << acos << asin << atan << cos << sin << tan << sqrt
-             << log10 << log << fabs << exp << floor << ceil << cosh
-             << sinh << tanh << tenPower << tenPower << acosh << asinh
-             << atanh << erf << erfc << tgamma << tgamma << cosh
-             << sinh << tanh << acosh << asinh << atanh;
+    bool ok = true;
+    return evaluateByteCode(code, x, k, ok);
 }
 
-double ExprCalculator::calculateFromTree(FastTree *tree, double x)
+void ExprCalculator::calculateOutputsFromByteCode(const ByteCode &code, double x, double *outputs)
 {
-    if(tree->type == NUMBER )
-    {
-        return *tree->value;
-    }
-    else if(tree->type == PAR_K)
-    {
-        return k;
-    }
-    else if(tree->type == VAR_X || tree->type == VAR_T)
-    {
-        return x;
-    }
-    else if(tree->type == PLUS)
-    {
-        return calculateFromTree(tree->left, x) + calculateFromTree(tree->right, x);
-    }
-    else if(tree->type == MINUS)
-    {
-        return calculateFromTree(tree->left, x) - calculateFromTree(tree->right, x);
-    }
-    else if(tree->type == MULTIPLY)
-    {
-        return calculateFromTree(tree->left, x) * calculateFromTree(tree->right, x);
-    }
-    else if(tree->type == DIVIDE)
-    {
-        return calculateFromTree(tree->left, x) / calculateFromTree(tree->right, x);
-    }
-    else if(tree->type == POW)
-    {
-        return pow(calculateFromTree(tree->left, x), calculateFromTree(tree->right, x));
-    }
-    else if(REF_FUNC_START < tree->type && tree->type < REF_FUNC_END)
-    {
-        return (*refFuncs[tree->type - REF_FUNC_START - 1])(calculateFromTree(tree->right, x));
-    }
-    else if(FUNC_START < tree->type && tree->type < FUNC_END)
-    {
-        int id = tree->type - FUNC_START - 1;
-        return funcCalculatorsList[id]->getFuncValue(calculateFromTree(tree->right, x), k);
-    }
-    else if(DERIV_START < tree->type && tree->type < DERIV_END)
+    bool ok = true;
+    evaluateByteCode(code, x, k, ok, outputs);
+}
+
+void ExprCalculator::calculateColumnFromByteCode(const ByteCode &code, const double *x, double *results, int first, int n)
+{
+    // rows [first, first+n) of the columns, "x" and the additionnal variables being read on the same row
+    bool ok = true;
+    evaluateByteCode(code, x + first, results + first, n, k, ok, first);
+}
+
+double ExprCalculator::callMathObject(short type, double arg, double k_val, bool &ok)
+{
+    Q_UNUSED(ok);
+
+    if(FUNC_START < type && type < FUNC_END)
     {
-        int id = tree->type - DERIV_START - 1;
-        return funcCalculatorsList[id]->getDerivativeValue(calculateFromTree(tree->right, x), k);
+        int id = type - FUNC_START - 1;
+        return funcCalculatorsList[id]->getCachedFuncValue(arg, k_val);
     }
-    else if(tree->type >= ADDITIONNAL_VARS_START)
+    else if(DERIV_START < type && type < DERIV_END)
     {
-        return additionnalVarsValues.at(tree->type - ADDITIONNAL_VARS_START);
+        int id = type - DERIV_START - 1;
+        return funcCalculatorsList[id]->getDerivativeValue(arg, k_val);
     }
 
     else return NAN;
 }
+
+double ExprCalculator::getAdditionnalVarValue(int index)
+{
+    return additionnalVarsValues.at(index);
+}
+
+void ExprCalculator::getAdditionnalVarValues(int index, int first, double *values, int n)
+{
+    if(index < additionnalVarsColumns.size())
+        memcpy(values, additionnalVarsColumns.at(index) + first, n * sizeof(double));
+    else ByteCodeEvaluator::getAdditionnalVarValues(index, first, values, n);
+}
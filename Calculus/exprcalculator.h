@@ -24,8 +24,9 @@
 #include "treecreator.h"
 #include "structures.h"
 #include "funccalculator.h"
+#include "bytecodeevaluator.h"
 
-class ExprCalculator
+class ExprCalculator : public ByteCodeEvaluator
 {
 public:
 
@@ -33,20 +34,24 @@ public:
 
     double calculateExpression(QString expr, bool &ok, double k_val = 0);
     void setAdditionnalVarsValues(QList<double> values);
+    void setAdditionnalVarsColumns(QList<const double*> columns);
     void setK(double val);
 
-    double calculateFromTree(FastTree *tree, double x = 0);
+    double calculateFromByteCode(const ByteCode &code, double x = 0);
+    void calculateOutputsFromByteCode(const ByteCode &code, double x, double *outputs);
+    void calculateColumnFromByteCode(const ByteCode &code, const double *x, double *results, int first, int n);
     bool checkCalledFuncsValidity(QString expr);
 
 protected:    
-    void addRefFuncsPointers();
+    double callMathObject(short type, double arg, double k_val, bool &ok);
+    double getAdditionnalVarValue(int index);
+    void getAdditionnalVarValues(int index, int first, double *values, int n);
 
     double k;
-    FastTree *currentTree;
     TreeCreator treeCreator;
     QList<FuncCalculator*> funcCalculatorsList;
-    QList<double (*)(double)> refFuncs;
     QList<double> additionnalVarsValues;
+    QList<const double*> additionnalVarsColumns; // a value per row, read by calculateColumnFromByteCode()
 };
 
 #endif // EXPRCALCULATOR_H
@@ -21,6 +21,8 @@
 
 #include "Calculus/funccalculator.h"
 
+QAtomicInt FuncCalculator::cachesGeneration(0);
+
 static double tenPower(double x)
 {
      return pow(10, x);
@@ -29,16 +31,20 @@ static double tenPower(double x)
 FuncCalculator::FuncCalculator(int id, QString funcName, QLabel *errorLabel) : treeCreator(FUNCTION)
 {
     errorMessageLabel = errorLabel;
-    funcTree = NULL;
     funcNum = id;
+    revision = 0;
+    kRange.start = kRange.end = 0;
+    kRange.step = 1;
     isExprValidated = areCalledFuncsGood = areIntegrationPointsGood = isParametric = false;
     name = funcName;    
 
-    addRefFuncsPointers();
-
     drawState = true;
     callLock = false;
 
+    ownCachesGeneration.store(cachesGeneration.load());
+    kDependency.store(true);
+    antiderivativeNodesCount = 0;
+
     for(short i = 0 ; i < 6 ; i++)
     {
         Point pt;
@@ -55,7 +61,18 @@ void FuncCalculator::setColorSaver(ColorSaver *colsaver)
 
 void FuncCalculator::setIntegrationPointsList(QList<Point> list)
 {
+    bool changed = list.size() != integrationPoints.size();
+
+    for(int i = 0 ; i < list.size() && !changed ; i++)
+        changed = list[i].x != integrationPoints[i].x || list[i].y != integrationPoints[i].y;
+
     integrationPoints = list;
+
+    if(changed)
+    {
+        revision++;
+        invalidateCaches();
+    }
 }
 
 ColorSaver* FuncCalculator::getColorSaver()
@@ -63,15 +80,6 @@ ColorSaver* FuncCalculator::getColorSaver()
     return colorSaver;
 }
 
-void FuncCalculator::addRefFuncsPointers()
-{
-    refFuncs << acos << asin << atan << cos << sin << tan << sqrt
-             << log10 << log << fabs << exp << floor << ceil << cosh
-             << sinh << tanh << tenPower << tenPower << acosh << asinh
-             << atanh << erf << erfc << tgamma << tgamma << cosh
-             << sinh << tanh << acosh << asinh << atanh; //tenPower must figure two times for e and E
-}
-
 bool FuncCalculator::getDrawState()
 {
     return drawState && isFuncValid();
@@ -81,11 +89,11 @@ bool FuncCalculator::validateExpression(QString expr)
 {   
     if(expression != expr)
     {
-        if(funcTree != NULL)
-            treeCreator.deleteFastTree(funcTree);
-
-        funcTree = treeCreator.getTreeFromExpr(expr, isExprValidated);
+        funcCode = treeCreator.getByteCodeFromExpr(expr, isExprValidated);
         expression = expr;
+        revision++;
+
+        invalidateCaches();
 
         integrationPoints.clear();
     }
@@ -96,80 +104,277 @@ bool FuncCalculator::validateExpression(QString expr)
 void FuncCalculator::setFuncsPointers(QList<FuncCalculator*> otherFuncs)
 {
     funcCalculatorsList = otherFuncs;
+    invalidateCaches();
 
 }
 
-int int_pow(int a, int b)
+double FuncCalculator::getAntiderivativeValue(double b, Point A, double k_val)
 {
-    if(b==0)
-        return 1;
+    /* The integral from A.x is kept at every abscissa already asked for: b is integrated from
+       the nearest of them only, so sampling F along a grid, or extending it while panning,
+       costs one small integration per sample instead of one from A.x. */
+
+    updateCaches();
+
+    if(std::isnan(b))
+        return NAN;
+
+    QPair<double, double> key = qMakePair(A.x, cacheKey(k_val));
+    double nearestX, nearestIntegral;
 
-    while(b != 1)
+    cachesMutex.lock();
+
+    if(antiderivativeNodesCount >= MAX_ANTIDERIVATIVE_NODES)
     {
-        a *= a;
-        b--;
+        antiderivativeNodes.clear();
+        antiderivativeNodesCount = 0;
     }
 
-    return a;
+    QMap<double, double> &nodes = antiderivativeNodes[key];
+
+    if(nodes.isEmpty())
+    {
+        nodes.insert(A.x, 0);
+        antiderivativeNodesCount++;
+    }
+
+    QMap<double, double>::iterator nearest = nodes.lowerBound(b);
+
+    if(nearest != nodes.end() && nearest.key() == b)
+    {
+        nearestIntegral = nearest.value();
+        cachesMutex.unlock();
+        return nearestIntegral + A.y;
+    }
+
+    if(nearest == nodes.end())
+        nearest--;
+    else if(nearest != nodes.begin())
+    {
+        QMap<double, double>::iterator previous = nearest;
+        previous--;
+        if(b - previous.key() < nearest.key() - b)
+            nearest = previous;
+    }
+
+    nearestX = nearest.key();
+    nearestIntegral = nearest.value();
+
+    cachesMutex.unlock(); // the integration calls other functions, which lock their own caches
+
+    double integral = nearestIntegral + integrate(nearestX, b, k_val);
+
+    if(!std::isnan(integral))
+    {
+        QMutexLocker locker(&cachesMutex);
+        antiderivativeNodes[key].insert(b, integral);
+        antiderivativeNodesCount++;
+    }
+
+    return integral + A.y;
 }
 
-double FuncCalculator::getAntiderivativeValue(double b, Point A, double k_val)
-{   
-    double a = A.x, fa, fb, hn, result, powResult, diff, condition;
+double FuncCalculator::integrate(double a, double b, double k_val)
+{
+    double fa = getFuncValue(a, k_val), fb = getFuncValue(b, k_val), fm = getFuncValue((a+b)/2, k_val);
+    double whole = (b-a)/6 * (fa + 4*fm + fb);
 
-    condition = tenPower(-NUM_PREC);
+    return adaptiveSimpson(a, b, fa, fm, fb, whole, tenPower(-NUM_PREC) * fabs(b-a), 0, k_val);
+}
 
-    fa = getFuncValue(a, k_val);
-    fb = getFuncValue(b, k_val);
+double FuncCalculator::adaptiveSimpson(double a, double b, double fa, double fm, double fb, double whole, double eps, int depth, double k_val)
+{
+    double m = (a+b)/2, flm = getFuncValue((a+m)/2, k_val), frm = getFuncValue((m+b)/2, k_val);
+    double left = (m-a)/6 * (fa + 4*flm + fm), right = (b-m)/6 * (fm + 4*frm + fb);
+    double diff = left + right - whole;
 
-    if(std::isnan(fa) || std::isinf(fa) || std::isnan(fb) || std::isinf(fb))
-        return NAN;
+    if(std::isnan(diff) || depth >= MAX_SIMPSON_DEPTH || fabs(diff) <= 15*eps)
+        return left + right + diff/15;
+
+    return adaptiveSimpson(a, m, fa, flm, fm, left, eps/2, depth+1, k_val) +
+           adaptiveSimpson(m, b, fm, frm, fb, right, eps/2, depth+1, k_val);
+}
 
-    QList< QList<double> > R;
-    QList<double> L1;
+double FuncCalculator::getFuncValue(double x, double kValue)
+{    
+    bool ok = true;
+    return evaluateByteCode(funcCode, x, kValue, ok);
+}
+
+double FuncCalculator::getCachedFuncValue(double x, double kValue)
+{
+    updateCaches();
 
-    L1 << 0.5*(b-a)*(fa+fb);
+    double y, key_k = cacheKey(kValue);
 
-    R << L1;
+    cachesMutex.lock();
+
+    int index = gridIndex.value(x, -1);
+    bool found = false;
+
+    if(index != -1 && gridValues.contains(key_k))
+    {
+        y = gridValues.value(key_k).at(index);
+        found = true;
+    }
+    else found = valuesCache.find(x, key_k, y);
 
-    int i = 0, end = 0;
+    cachesMutex.unlock();
 
-    do
+    if(!found)
     {
-        i++;
-        end = int_pow(2, i-1);
-        hn = (b-a)/(double(2*end));
-        result = 0;
+        y = getFuncValue(x, kValue);
 
-        for(int j = 1 ; j <= end ; j++)
-            result += getFuncValue(a + ((double(2*j)) - 1)*hn, k_val);
+        QMutexLocker locker(&cachesMutex);
+        valuesCache.insert(x, key_k, y);
+    }
+
+    return y;
+}
+
+void FuncCalculator::getFuncValues(const double *x, double *y, size_t n, double kValue)
+{
+    if(copyFromSampledGrid(x, y, n, kValue))
+        return;
+
+    bool ok = true;
+    evaluateByteCode(funcCode, x, y, n, kValue, ok);
+}
+
+void FuncCalculator::sampleFuncValues(const double *x, double *y, size_t n, double kValue)
+{
+    bool ok = true;
+    evaluateByteCode(funcCode, x, y, n, kValue, ok); // never from the saved grid, which may be the outdated one
+    saveSampledGrid(x, y, n, kValue);
+}
 
-        QList<double> L;
-        L.reserve(i);
-        L << 0.5*R[i-1][0] + hn*result;
+void FuncCalculator::invalidateCaches()
+{
+    cachesGeneration.ref();
+}
+
+void FuncCalculator::updateCaches()
+{
+    int generation = cachesGeneration.load();
 
-        for(int j = 1; j <= i ; j++)
-        {
-            powResult = int_pow(4, j);
-            L << (powResult*L[j-1] - R[i-1][j-1])/(powResult-1);
-        }
+    if(ownCachesGeneration.load() == generation)
+        return;
 
-        R << L;
+    bool dependency = computeKDependency(); // without the mutex: the called functions update their own caches
 
-        diff = fabs(R[i][i] - R[i-1][i-1]);
+    QMutexLocker locker(&cachesMutex);
 
+    if(ownCachesGeneration.load() == generation) // another thread got there first
+        return;
 
-    }while(diff > condition);
+    valuesCache.clear();
+    derivativesCache.clear();
 
-    return R[i][i] + A.y;
+    antiderivativeNodes.clear();
+    antiderivativeNodesCount = 0;
 
+    gridX.clear();
+    gridIndex.clear();
+    gridValues.clear();
 
+    kDependency.store(dependency);
+    ownCachesGeneration.store(generation);
 }
 
-double FuncCalculator::getFuncValue(double x, double kValue)
-{    
-    k = kValue;
-    return calculateFromTree(funcTree, x);
+bool FuncCalculator::computeKDependency()
+{
+    for(int i = 0 ; i < funcCode.instructions.size() ; i++)
+    {
+        short type = funcCode.instructions[i].type;
+        bool dependency = false;
+
+        if(type == PAR_K)
+            dependency = true;
+        else if(FUNC_START < type && type < FUNC_END)
+            dependency = funcCalculatorsList[type - FUNC_START - 1]->dependsOnK();
+        else if(DERIV_START < type && type < DERIV_END)
+            dependency = funcCalculatorsList[type - DERIV_START - 1]->dependsOnK();
+        else if(INTEGRATION_FUNC_START < type && type < INTEGRATION_FUNC_END)
+            dependency = funcCalculatorsList[type - INTEGRATION_FUNC_START - 1]->dependsOnK();
+
+        if(dependency)
+            return true;
+    }
+
+    return false;
+}
+
+bool FuncCalculator::dependsOnK()
+{
+    updateCaches();
+    return kDependency.load();
+}
+
+double FuncCalculator::cacheKey(double k_val)
+{
+    return kDependency.load() ? k_val : 0; // so that every k shares the values of a function that doesn't use it
+}
+
+int FuncCalculator::getRevision()
+{
+    return revision;
+}
+
+QList<int> FuncCalculator::getCalledFuncs()
+{
+    return treeCreator.getCalledFuncs(expression);
+}
+
+bool FuncCalculator::copyFromSampledGrid(const double *x, double *y, int n, double k_val)
+{
+    updateCaches();
+
+    if(n == 0)
+        return false;
+
+    QMutexLocker locker(&cachesMutex);
+
+    int index = gridIndex.value(x[0], -1);
+
+    if(index == -1 || index + n > gridX.size() || memcmp(x, gridX.constData() + index, n * sizeof(double)) != 0)
+        return false;
+
+    QHash<double, QVector<double> >::const_iterator values = gridValues.constFind(cacheKey(k_val));
+
+    if(values == gridValues.constEnd())
+        return false;
+
+    memcpy(y, values.value().constData() + index, n * sizeof(double));
+
+    return true;
+}
+
+void FuncCalculator::saveSampledGrid(const double *x, const double *y, int n, double k_val)
+{
+    updateCaches();
+
+    QMutexLocker locker(&cachesMutex);
+
+    if(gridX.size() != n || memcmp(x, gridX.constData(), n * sizeof(double)) != 0)
+    {
+        gridX.resize(n);
+        memcpy(gridX.data(), x, n * sizeof(double));
+
+        gridIndex.clear();
+        gridValues.clear();
+
+        for(int i = 0 ; i < n ; i++)
+            gridIndex.insert(x[i], i);
+    }
+
+    double key_k = cacheKey(k_val);
+
+    if(gridValues.size() < PAR_DRAW_LIMIT || gridValues.contains(key_k))
+    {
+        QVector<double> values(n);
+        memcpy(values.data(), y, n * sizeof(double));
+        gridValues.insert(key_k, values);
+    }
 }
 
 void FuncCalculator::setDrawState(bool draw)
@@ -179,18 +384,31 @@ void FuncCalculator::setDrawState(bool draw)
 
 double FuncCalculator::getDerivativeValue(double x, double k_val)
 {
-    k = k_val;
-    double y1, y2, y3, y4, a;
+    updateCaches();
+
+    double a, key_k = cacheKey(k_val);
+
+    cachesMutex.lock();
+    bool found = derivativesCache.find(x, key_k, a);
+    cachesMutex.unlock();
+
+    if(found)
+        return a;
+
+    getFuncValueAndDerivative(x, k_val, a);
 
-    y1 = getFuncValue(x - 2*EPSILON, k);
-    y2 = 8*getFuncValue(x - EPSILON, k);
-    y3 = 8*getFuncValue(x + EPSILON, k);
-    y4 = getFuncValue(x + 2*EPSILON, k);
-    a = (y1 - y2 + y3 - y4)/(12*EPSILON);
+    QMutexLocker locker(&cachesMutex);
+    derivativesCache.insert(x, key_k, a);
 
     return a;
 }
 
+double FuncCalculator::getFuncValueAndDerivative(double x, double k_val, double &derivative)
+{
+    bool ok = true;
+    return evaluateDualByteCode(funcCode, x, k_val, ok, derivative);
+}
+
 void FuncCalculator::setIntegrationPointsValidity(bool state)
 {
     areIntegrationPointsGood = state;
@@ -230,6 +448,9 @@ bool FuncCalculator::checkFuncCallingInclusions()
 
 void FuncCalculator::setParametric(bool state)
 {
+    if(isParametric != state)
+        revision++;
+
     isParametric = state;
 }
 
@@ -246,6 +467,8 @@ bool FuncCalculator::isFuncValid()
 void FuncCalculator::setInvalid()
 {
     isExprValidated = false;
+    revision++;
+    invalidateCaches();
 }
 
 Range FuncCalculator::getParametricRange()
@@ -255,6 +478,9 @@ Range FuncCalculator::getParametricRange()
 
 void FuncCalculator::setParametricRange(Range range)
 {
+    if(range.start != kRange.start || range.end != kRange.end || range.step != kRange.step)
+        revision++;
+
     kRange = range;
 }
 
@@ -263,59 +489,60 @@ bool FuncCalculator::canBeCalled()
     return isExprValidated && areIntegrationPointsGood && areCalledFuncsGood && !callLock;
 }
 
-double FuncCalculator::calculateFromTree(FastTree *tree, double x)
+double FuncCalculator::callMathObject(short type, double arg, double k_val, bool &ok)
 {
-    if(tree->type == NUMBER )
-    {
-        return *tree->value;
-    }
-    else if(tree->type == VAR_X || tree->type == VAR_T)
-    {
-        return x;
-    }
-    else if(tree->type == PAR_K)
-    {
-        return k;
-    }
-    else if(tree->type == PLUS)
-    {
-        return calculateFromTree(tree->left, x) + calculateFromTree(tree->right, x);
-    }
-    else if(tree->type == MINUS)
-    {
-        return calculateFromTree(tree->left, x) - calculateFromTree(tree->right, x);
-    }
-    else if(tree->type == MULTIPLY)
+    Q_UNUSED(ok);
+
+    if(FUNC_START < type && type < FUNC_END)
     {
-        return calculateFromTree(tree->left, x) * calculateFromTree(tree->right, x);
+        int id = type - FUNC_START - 1;
+        return funcCalculatorsList[id]->getCachedFuncValue(arg, k_val);
     }
-    else if(tree->type == DIVIDE)
+    else if(DERIV_START < type && type < DERIV_END)
     {
-        return calculateFromTree(tree->left, x) / calculateFromTree(tree->right, x);
+        int id = type - DERIV_START - 1;
+        return funcCalculatorsList[id]->getDerivativeValue(arg, k_val);
     }
-    else if(tree->type == POW)
+    else if(INTEGRATION_FUNC_START < type && type < INTEGRATION_FUNC_END)
     {
-        return pow(calculateFromTree(tree->left, x), calculateFromTree(tree->right, x));
+        int id = type - INTEGRATION_FUNC_START - 1;
+        return funcCalculatorsList[id]->getAntiderivativeValue(arg, integrationPoints[id], k_val);
     }
-    else if(REF_FUNC_START < tree->type && tree->type < REF_FUNC_END)
+
+    else return NAN;
+}
+
+double FuncCalculator::callMathObjectDerivative(short type, double arg, double k_val, bool &ok)
+{
+    Q_UNUSED(ok);
+
+    if(FUNC_START < type && type < FUNC_END)
     {
-        return (*refFuncs[tree->type - REF_FUNC_START - 1])(calculateFromTree(tree->right, x));
+        int id = type - FUNC_START - 1;
+        return funcCalculatorsList[id]->getDerivativeValue(arg, k_val);
     }
-    else if(FUNC_START < tree->type && tree->type < FUNC_END)
+    else if(DERIV_START < type && type < DERIV_END)
     {
-        int id = tree->type - FUNC_START - 1;
-        return funcCalculatorsList[id]->getFuncValue(calculateFromTree(tree->right, x), k);
+        // second derivative: central difference of the exact first derivative
+        int id = type - DERIV_START - 1;
+        return (funcCalculatorsList[id]->getDerivativeValue(arg + EPSILON, k_val) -
+                funcCalculatorsList[id]->getDerivativeValue(arg - EPSILON, k_val)) / (2*EPSILON);
     }
-    else if(DERIV_START < tree->type && tree->type < DERIV_END)
-    {             
-        int id = tree->type - DERIV_START - 1;
-        return funcCalculatorsList[id]->getDerivativeValue(calculateFromTree(tree->right, x), k);
-    }   
-    else if(INTEGRATION_FUNC_START < tree->type && tree->type < INTEGRATION_FUNC_END)
+    else if(INTEGRATION_FUNC_START < type && type < INTEGRATION_FUNC_END)
     {
-        int id = tree->type - INTEGRATION_FUNC_START - 1;
-        return funcCalculatorsList[id]->getAntiderivativeValue(calculateFromTree(tree->right, x), integrationPoints[id], k);
+        int id = type - INTEGRATION_FUNC_START - 1;
+        return funcCalculatorsList[id]->getCachedFuncValue(arg, k_val);
     }
 
     else return NAN;
 }
+
+void FuncCalculator::callMathObjectOnArray(short type, const double *args, double *results, int n, double k_val, bool &ok)
+{
+    if(FUNC_START < type && type < FUNC_END)
+    {
+        int id = type - FUNC_START - 1;
+        funcCalculatorsList[id]->getFuncValues(args, results, n, k_val);
+    }
+    else ByteCodeEvaluator::callMathObjectOnArray(type, args, results, n, k_val, ok);
+}
@@ -25,9 +25,14 @@
 
 #include "structures.h"
 #include "treecreator.h"
+#include "bytecodeevaluator.h"
+#include "valuescache.h"
 #include "colorsaver.h"
 
-class FuncCalculator : public QObject
+#define MAX_ANTIDERIVATIVE_NODES 200000
+#define MAX_SIMPSON_DEPTH 20
+
+class FuncCalculator : public QObject, public ByteCodeEvaluator
 {
     Q_OBJECT
 
@@ -49,7 +54,16 @@ public:
 
     double getAntiderivativeValue(double b, Point A, double k_val = 0);
     double getFuncValue(double x, double kValue = 0);
+    double getCachedFuncValue(double x, double kValue = 0);
+    void getFuncValues(const double *x, double *y, size_t n, double kValue = 0);
+    void sampleFuncValues(const double *x, double *y, size_t n, double kValue = 0);
     double getDerivativeValue(double x, double k_val = 0);
+    double getFuncValueAndDerivative(double x, double k_val, double &derivative);
+
+    static void invalidateCaches();
+    int getRevision();
+    QList<int> getCalledFuncs();
+    bool dependsOnK();
 
 
     bool canBeCalled();
@@ -64,14 +78,24 @@ public slots:
     void setDrawState(bool draw);
 
 protected:
-    double calculateFromTree(FastTree *tree, double x);
-    void addRefFuncsPointers();     
+    double callMathObject(short type, double arg, double k_val, bool &ok);
+    void callMathObjectOnArray(short type, const double *args, double *results, int n, double k_val, bool &ok);
+    double callMathObjectDerivative(short type, double arg, double k_val, bool &ok);
+
+    double integrate(double a, double b, double k_val);
+    double adaptiveSimpson(double a, double b, double fa, double fm, double fb, double whole, double eps, int depth, double k_val);
+
+    void updateCaches();
+    bool computeKDependency();
+    double cacheKey(double k_val);
+    bool copyFromSampledGrid(const double *x, double *y, int n, double k_val);
+    void saveSampledGrid(const double *x, const double *y, int n, double k_val);
 
     int funcNum;
-    double k;
+    int revision; // incremented whenever what the function computes changes
     bool isExprValidated, isParametric, areCalledFuncsGood, areIntegrationPointsGood, drawState, callLock;
     TreeCreator treeCreator;
-    FastTree *funcTree;
+    ByteCode funcCode;
     QString expression, name;
     QList<FuncCalculator*> funcCalculatorsList;
     Range kRange;    
@@ -79,7 +103,24 @@ protected:
     QLabel *errorMessageLabel;
 
     QList<Point> integrationPoints;
-    QList<double (*)(double)> refFuncs;    
+
+    /* Values memoized for the other math objects calling this function. They are dropped whenever
+       cachesGeneration moves on: at each redraw and whenever a function's definition changes.
+       FuncValuesSaver samples several functions and k values at once, in the background, while the
+       GUI thread evaluates tangents or hovered curves, so they are only accessed under cachesMutex. It is never held while evaluating,
+       nor while updateCaches() asks the called functions whether they depend on k. The generation and the dependency are
+       atomics: samplers read them without the mutex, and only ever see a fully computed dependency. */
+    static QAtomicInt cachesGeneration;
+    QAtomicInt ownCachesGeneration, kDependency;
+    QMutex cachesMutex;
+    ValuesCache valuesCache, derivativesCache;
+
+    QHash<QPair<double, double>, QMap<double, double> > antiderivativeNodes; // (A.x, k) -> x -> integral from A.x to x
+    int antiderivativeNodesCount;
+
+    QVector<double> gridX; // last abscissas sampled by FuncValuesSaver, and the values for each k
+    QHash<double, int> gridIndex;
+    QHash<double, QVector<double> > gridValues;
 };
 
 #endif // FUNCCALCULATOR_H
@@ -20,15 +20,24 @@
 
 
 #include "Calculus/funcvaluessaver.h"
+#include <QtConcurrent>
 
 
 FuncValuesSaver::FuncValuesSaver(QList<FuncCalculator*> funcsList, double pxStep)
 {    
     funcs = funcsList;
+    cancelFlag = NULL;
+    calculationId = 0;
+    xUnit = yUnit = 1;
+    unitStep = 0;
+    sampledXUnit = sampledYUnit = sampledPixelStep = 0;
     setPixelStep(pxStep);
 
     for(short i = 0 ; i < funcs.size() ; i++)
-        funcCurves << QList<QList<QPolygonF>>();
+    {
+        funcCurves << QList<CurveBuffer>();
+        sampledDependencies << QVector<int>();
+    }
 }
 
 void FuncValuesSaver::setPixelStep(double pxStep)
@@ -36,258 +45,458 @@ void FuncValuesSaver::setPixelStep(double pxStep)
     pixelStep = pxStep;
 }
 
-double FuncValuesSaver::evalFunc(int funId, double x, double k)
+void FuncValuesSaver::fillXValues(double xFrom, double xTo, double step)
+{
+    xViewVals.clear();
+    xVals.clear();
+
+    if(step > 0)
+    {
+        for(double x = xFrom ; x <= xTo ; x += step)
+            xViewVals << x;
+    }
+    else
+    {
+        for(double x = xFrom ; x >= xTo ; x += step)
+            xViewVals << x;
+    }
+
+    for(int col = 0 ; col < xViewVals.size() ; col++)
+        xVals << graphView.viewToUnit_x(xViewVals[col]);
+}
+
+void FuncValuesSaver::addToSamplingOrder(int funId, QList<int> &visited)
+{
+    if(visited.contains(funId))
+        return;
+
+    visited << funId;
+
+    QList<int> calledFuncs = funcs[funId]->getCalledFuncs();
+
+    for(int i = 0 ; i < calledFuncs.size() ; i++)
+        addToSamplingOrder(calledFuncs[i], visited);
+
+    samplingOrder << funId;
+}
+
+QVector<int> FuncValuesSaver::getDependencies(int funId)
+{
+    QVector<int> dependencies(funcs.size(), -1);
+    QList<int> toVisit;
+    toVisit << funId;
+
+    while(!toVisit.isEmpty())
+    {
+        int id = toVisit.takeLast();
+
+        if(dependencies[id] != -1)
+            continue;
+
+        dependencies[id] = funcs[id]->getRevision();
+        toVisit << funcs[id]->getCalledFuncs();
+    }
+
+    return dependencies;
+}
+
+
+bool FuncValuesSaver::isCancelled()
 {
-    return funcs[funId]->getFuncValue(x, k);
+    return cancelFlag != NULL && cancelFlag->load() != 0;
 }
 
+bool FuncValuesSaver::isSampledAt(double new_xUnit, double new_yUnit, ZeGraphView view)
+{
+    return view.viewRect() == sampledRect && new_xUnit == sampledXUnit && new_yUnit == sampledYUnit;
+}
 
-void FuncValuesSaver::calculateAll(double new_xUnit, double new_yUnit, ZeGraphView view)
+bool FuncValuesSaver::calculateAll(double new_xUnit, double new_yUnit, ZeGraphView view, const QAtomicInt *cancelled)
 {
+    cancelFlag = cancelled;
     graphView = view;
     xUnit = new_xUnit;
     yUnit = new_yUnit;
     unitStep = pixelStep / xUnit;
 
-    double x = 0, k = 0, delta1 = 0, delta2 = 0, delta3 = 0, y=0;
-    int k_pos = 0, end=0, n=0;
+    double k = 0;
+    int k_pos = 0, end = 0;
 
     Range range;
-    QPolygonF curvePart;
-    QPointF pt1, pt2;
 
     double xStart = graphView.viewRect().left() - unitStep;
     double xEnd = graphView.viewRect().right() + unitStep;
 
+    fillXValues(xStart, xEnd, unitStep);
+
+    if(graphView.viewRect() != sampledRect || xUnit != sampledXUnit || yUnit != sampledYUnit || pixelStep != sampledPixelStep)
+    {
+        // every curve is sampled again, on new abscissas: the functions' saved samples can't be reused
+        FuncCalculator::invalidateCaches();
+
+        for(short i = 0 ; i < funcs.size() ; i++)
+            sampledDependencies[i].clear();
+
+        sampledRect = graphView.viewRect();
+        sampledXUnit = xUnit;
+        sampledYUnit = yUnit;
+        sampledPixelStep = pixelStep;
+    }
+
+    QVector<bool> dirty(funcs.size());
+    bool resampled = false;
+
     for(short i = 0; i < funcs.size(); i++)
     {
         if(!funcs[i]->isFuncValid())
+        {
+            resampled = resampled || !funcCurves[i].isEmpty();
+            funcCurves[i].clear();
+            sampledDependencies[i].clear();
+            dirty[i] = false;
             continue;
+        }
+
+        dirty[i] = getDependencies(i) != sampledDependencies[i];
+        resampled = resampled || dirty[i];
+
+        if(dirty[i])
+            sampledDependencies[i].clear(); // until its sampling completes
+    }
 
-        funcCurves[i].clear();
-
-        range = funcs[i]->getParametricRange();
-        end = trunc((range.end - range.start)/range.step) + 1;
-        k = range.start;
-
-        for(k_pos = 0 ; k_pos < end && k_pos < PAR_DRAW_LIMIT ; k_pos++)
-        {            
-            funcCurves[i] << QList<QPolygonF>();
-            curvePart.clear();
-
-            for(x = xStart ; x <= xEnd; x += unitStep)
-            {                
-                y = evalFunc(i, view.viewToUnit_x(x), k);
-
-                if(std::isnan(y) || std::isinf(y))
-                {
-                    if(!curvePart.isEmpty())
-                    {
-                        funcCurves[i][k_pos] << curvePart;
-                        curvePart.clear();
-                    }
-                }
-                else
-                {
-                    curvePart <<  QPointF( x ,  view.unitToView_y(y));
-
-                    n = curvePart.size();
-                    if(n > 1)
-                        delta3 = fabs(curvePart[n-1].y() - curvePart[n-2].y());
-
-                    if(n > 2 && delta2 > 4*delta1 && delta2 > 4*delta3)
-                    {
-                        pt1 = curvePart[n-2];
-                        pt2 = curvePart[n-1];
-
-                        curvePart.removeLast();
-                        curvePart.removeLast();
-
-                        funcCurves[i][k_pos] << curvePart;
-                        curvePart.clear();
-                        curvePart << pt1 << pt2;
-                    }
-
-                    delta1 = delta2;
-                    delta2 = delta3;
-
-                }
+    if(!resampled)
+    {
+        cancelFlag = NULL;
+        return true;
+    }
+
+    calculationId++;
+
+    QList<int> visited;
+    samplingOrder.clear();
+
+    for(short i = 0; i < funcs.size(); i++)
+        addToSamplingOrder(i, visited);
+
+    /* A function's level is one more than the highest level of the functions it calls. Levels are
+       sampled one after the other, so that called functions have all their samples saved when their
+       callers use them. Within a level, every (function, k) curve is an independent job. */
+
+    QVector<int> levels(funcs.size(), 0);
+    int maxLevel = 0;
+
+    for(short pos = 0; pos < samplingOrder.size(); pos++)
+    {
+        short i = samplingOrder[pos];
+        QList<int> calledFuncs = funcs[i]->getCalledFuncs();
+
+        for(int j = 0 ; j < calledFuncs.size() ; j++)
+            levels[i] = qMax(levels[i], levels[calledFuncs[j]] + 1);
+
+        maxLevel = qMax(maxLevel, levels[i]);
+    }
+
+    for(int level = 0 ; level <= maxLevel && !isCancelled() ; level++)
+    {
+        QVector<SamplingJob> jobs;
+
+        for(short pos = 0; pos < samplingOrder.size(); pos++)
+        {
+            short i = samplingOrder[pos];
+
+            if(levels[i] != level || !dirty[i])
+                continue;
+
+            funcs[i]->dependsOnK(); // brings its caches, and its called functions' ones, up to date before the threads share them
+            funcCurves[i].clear();
+
+            range = funcs[i]->getParametricRange();
+            end = trunc((range.end - range.start)/range.step) + 1;
+            k = range.start;
+
+            for(k_pos = 0 ; k_pos < end && k_pos < PAR_DRAW_LIMIT ; k_pos++)
+            {
+                SamplingJob job;
+                job.func = i;
+                job.kPos = k_pos;
+                job.k = k;
+                jobs << job;
+
+                funcCurves[i] << CurveBuffer();
+
+                k += range.step;
             }
+        }
 
-            if(!curvePart.isEmpty())
-                funcCurves[i][k_pos] << curvePart;
-            curvePart.clear();
+        QtConcurrent::blockingMap(jobs, [this](SamplingJob &job) { if(!isCancelled()) sampleCurve(job); });
+
+        for(int j = 0 ; j < jobs.size() ; j++)
+            funcCurves[jobs[j].func][jobs[j].kPos] = jobs[j].curve;
+
+        for(short i = 0; i < funcs.size() && !isCancelled(); i++)
+            if(levels[i] == level && dirty[i])
+                sampledDependencies[i] = getDependencies(i);
+    }
 
-            k += range.step;           
+    bool completed = !isCancelled(); // the curves are left incomplete otherwise
+    cancelFlag = NULL;
+
+    return completed;
+}
+
+double FuncValuesSaver::evalViewPoint(SamplingJob &job, double xView)
+{
+    job.evaluationsLeft--;
+    return graphView.unitToView_y(funcs[job.func]->getFuncValue(graphView.viewToUnit_x(xView), job.k));
+}
+
+void FuncValuesSaver::sampleCurve(SamplingJob &job)
+{
+    /* The evenly spaced samples, evaluated in one batch, are refined: steep parts are subdivided
+       until consecutive points are close enough on screen, a gap that doesn't close however close
+       the abscissas get, from beyond one edge of the view to beyond the other, is a pole and breaks
+       the curve, the ends of the definition domain are located by bisection, and points lying on the
+       chord of their neighbours are dropped. Past its evaluations budget, a curve is joined as is. */
+
+    job.evaluationsLeft = ADAPTIVE_EVALUATIONS_PER_SAMPLE * xVals.size();
+
+    QVector<double> values(xVals.size());
+    funcs[job.func]->sampleFuncValues(xVals.constData(), values.data(), xVals.size(), job.k);
+
+    QPolygonF curvePart;
+    QPointF previous, point;
+    bool previousValid = false, valid;
+
+    for(int col = 0 ; col < xVals.size() && !isCancelled() ; col++)
+    {
+        point = QPointF(xViewVals[col], graphView.unitToView_y(values[col]));
+        valid = !std::isnan(point.y()) && !std::isinf(point.y());
+
+        if(valid && previousValid)
+            refineSegment(job, previous, point, 0, curvePart);
+        else if(valid && col > 0)
+            extendToDomainBoundary(job, point, previous.x(), curvePart);
+        else if(!valid && previousValid)
+        {
+            extendToDomainBoundary(job, previous, point.x(), curvePart);
+            endCurvePart(job, curvePart);
         }
+
+        if(valid)
+            curvePart << point;
+
+        previous = point;
+        previousValid = valid;
+    }
+
+    endCurvePart(job, curvePart);
+}
+
+double FuncValuesSaver::clampToView(double yView)
+{
+    QRectF rect = graphView.viewRect();
+    return qBound(qMin(rect.top(), rect.bottom()), yView, qMax(rect.top(), rect.bottom()));
+}
+
+void FuncValuesSaver::refineSegment(SamplingJob &job, QPointF a, QPointF b, int depth, QPolygonF &curvePart)
+{
+    // only the visible part of the gap matters: a segment going off the view far away is not refined further
+    if(fabs(clampToView(b.y()) - clampToView(a.y())) * yUnit <= REFINE_PIXELS)
+        return;
+
+    if(isCancelled() || job.evaluationsLeft <= 0)
+        return;
+
+    if(depth == ADAPTIVE_MAX_DEPTH)
+    {
+        // still steep: continuous unless it crosses the whole view
+        QRectF rect = graphView.viewRect();
+        double top = qMax(rect.top(), rect.bottom()), bottom = qMin(rect.top(), rect.bottom());
+
+        if((a.y() > top && b.y() < bottom) || (a.y() < bottom && b.y() > top))
+            endCurvePart(job, curvePart);
+
+        return;
+    }
+
+    QPointF middle((a.x() + b.x())/2, evalViewPoint(job, (a.x() + b.x())/2));
+
+    if(std::isnan(middle.y()) || std::isinf(middle.y()))
+    {
+        extendToDomainBoundary(job, a, middle.x(), curvePart);
+        endCurvePart(job, curvePart);
+        extendToDomainBoundary(job, b, middle.x(), curvePart);
+        return;
+    }
+
+    refineSegment(job, a, middle, depth + 1, curvePart);
+    curvePart << middle;
+    refineSegment(job, middle, b, depth + 1, curvePart);
+}
+
+void FuncValuesSaver::extendToDomainBoundary(SamplingJob &job, QPointF defined, double undefinedX, QPolygonF &curvePart)
+{
+    QPointF boundary = defined;
+    double x, y;
+
+    for(int i = 0 ; i < ADAPTIVE_MAX_DEPTH && job.evaluationsLeft > 0 ; i++)
+    {
+        x = (boundary.x() + undefinedX)/2;
+        y = evalViewPoint(job, x);
+
+        if(std::isnan(y) || std::isinf(y))
+            undefinedX = x;
+        else boundary = QPointF(x, y);
+    }
+
+    if(boundary.x() == defined.x())
+        return;
+
+    if(undefinedX > defined.x()) // the boundary follows the defined point, which is already in curvePart
+    {
+        refineSegment(job, defined, boundary, 0, curvePart);
+        curvePart << boundary;
+    }
+    else
+    {
+        curvePart << boundary;
+        refineSegment(job, boundary, defined, 0, curvePart);
+    }
+}
+
+void FuncValuesSaver::endCurvePart(SamplingJob &job, QPolygonF &curvePart)
+{
+    if(curvePart.isEmpty())
+        return;
+
+    // keeps a point only if the chord from the last kept point to the next one strays too far from
+    // one of the points in between
+
+    job.curve.append(curvePart.first(), true);
+
+    int anchor = 0, n = curvePart.size();
+    double t, yChord;
+    bool skippable;
+
+    for(int i = 1 ; i < n - 1 ; i++)
+    {
+        skippable = i - anchor < MAX_DECIMATED_POINTS;
+
+        for(int j = anchor + 1 ; j <= i && skippable ; j++)
+        {
+            t = (curvePart[j].x() - curvePart[anchor].x()) / (curvePart[i+1].x() - curvePart[anchor].x());
+            yChord = curvePart[anchor].y() + t * (curvePart[i+1].y() - curvePart[anchor].y());
+            skippable = fabs(yChord - curvePart[j].y()) * yUnit <= DECIMATION_PIXELS;
+        }
+
+        if(!skippable)
+        {
+            job.curve.append(curvePart[i]);
+            anchor = i;
+        }
+    }
+
+    if(n > 1)
+        job.curve.append(curvePart.last());
+
+    curvePart.clear();
+}
+
+CurveBuffer FuncValuesSaver::sampleRange(int func, double k, double xFrom, double xTo)
+{
+    // the steps from xFrom towards xTo, xFrom included, sampled like a whole curve in increasing abscissas
+
+    fillXValues(xFrom, xTo, xFrom <= xTo ? unitStep : -unitStep);
+
+    if(xFrom > xTo)
+    {
+        std::reverse(xViewVals.begin(), xViewVals.end());
+        std::reverse(xVals.begin(), xVals.end());
     }
+
+    SamplingJob job;
+    job.func = func;
+    job.kPos = 0;
+    job.k = k;
+
+    sampleCurve(job);
+
+    return job.curve;
 }
 
 void FuncValuesSaver::move(ZeGraphView view)
 {
+    /* The abscissas the view now shows beyond a curve's ends are sampled through sampleCurve(), from the
+       curve's end point which is sampled again so that the segment joining them is refined too, and
+       spliced to the curve. Points moved out of the view are dropped. */
+
     graphView = view;
 
-    double x = 0, k = 0, k_step = 0, delta1 = 0, delta2 = 0, delta3 = 0, y=0;
+    double k = 0, k_step = 0;
     int k_pos = 0;
 
-
-    QPolygonF curvePart;
-    QPointF pt1, pt2;
-    int n = 0;
-
     double xStart = graphView.viewRect().left() - unitStep;
     double xEnd = graphView.viewRect().right() + unitStep;
 
-    for(short i = 0 ; i < funcs.size(); i++)
+    for(short pos = 0 ; pos < samplingOrder.size(); pos++)
     {
+        short i = samplingOrder[pos];
+
         if(!funcs[i]->isFuncValid())
             continue;
 
         k_step = funcs[i]->getParametricRange().step;
         k = funcs[i]->getParametricRange().start;
 
-        for(k_pos = 0; k_pos < funcCurves[i].size() ; k_pos++)
+        for(k_pos = 0; k_pos < funcCurves[i].size() ; k_pos++, k += k_step)
         {
-            curvePart = funcCurves[i][k_pos].takeFirst();
-            x = curvePart.first().x() - unitStep;
+            CurveBuffer &curve = funcCurves[i][k_pos];
 
-            if(x >= xStart)
+            if(curve.isEmpty()) // a curve undefined in the whole view is sampled again
             {
-                if(curvePart.size() >= 3)
-                {
-                    delta2 = fabs(curvePart[0].y() - curvePart[1].y());
-                    delta1 = fabs(curvePart[1].y() - curvePart[2].y());
-                }
-                else if(curvePart.size() == 2)
-                {
-                    delta2 = fabs(curvePart[0].y() - curvePart[1].y());
-                }
-
-
-                while(x >= xStart)
-                {
-                    y = evalFunc(i, view.viewToUnit_x(x), k);
-
-                    if(std::isnan(y) || std::isinf(y))
-                    {
-                        if(!curvePart.isEmpty())
-                        {
-                            funcCurves[i][k_pos].prepend(curvePart);
-                            curvePart.clear();
-                        }
-                    }
-                    else
-                    {
-                        curvePart.prepend(QPointF(x ,  view.unitToView_y(y)));
-
-                        n = curvePart.size();
-
-                        if(n > 1)
-                            delta3 = fabs(curvePart[0].y() - curvePart[1].y());
-
-                        if(n > 2 && delta2 > 4*delta1 && delta2 > 4*delta3)
-                        {
-                            pt1 = curvePart.takeFirst();
-                            pt2 = curvePart.takeFirst();
-
-                            funcCurves[i][k_pos].prepend(curvePart);
-                            curvePart.clear();
-                            curvePart << pt1 << pt2;
-                        }
-
-                        delta1 = delta2;
-                        delta2 = delta3;
-
-                    }
-
-                    x -= unitStep;
-                }
+                curve = sampleRange(i, k, xStart, xEnd);
+                continue;
+            }
+
+            if(curve.first().x() - unitStep >= xStart)
+            {
+                CurveBuffer added = sampleRange(i, k, curve.first().x(), xStart);
+                int end = added.size();
+
+                // the added curve ends with the current first point, which isn't added twice
+                if(end > 0 && added.last().x() == curve.first().x())
+                    end--;
+
+                for(int p = end - 1 ; p >= 0 ; p--)
+                    curve.prepend(added.at(p), p + 1 == added.size() || added.isBreak(p + 1));
             }
             else
             {
-                while(x < xStart)
-                {
-                    if(curvePart.isEmpty())
-                        curvePart = funcCurves[i][k_pos].takeFirst();
-                    curvePart.removeFirst();
-                    x += unitStep;
-                }                                
+                // points aren't evenly spaced, see sampleCurve(): those before the segment crossing the view's edge are dropped
+                while(!curve.isEmpty() && (curve.size() == 1 || curve.isBreak(1) ? curve.first().x() < xStart : curve.at(1).x() <= xStart))
+                    curve.removeFirst();
             }
 
-            if(!curvePart.isEmpty())
-                funcCurves[i][k_pos].prepend(curvePart);
-
-            curvePart.clear();
+            if(curve.isEmpty())
+                continue;
 
-            curvePart = funcCurves[i][k_pos].takeLast();
+            if(curve.last().x() + unitStep <= xEnd)
+            {
+                CurveBuffer added = sampleRange(i, k, curve.last().x(), xEnd);
+                int first = 0;
 
-            x = curvePart.last().x() + unitStep;
+                // the added curve starts with the current last point, which isn't added twice
+                if(!added.isEmpty() && added.first().x() == curve.last().x())
+                    first = 1;
 
-            if(x <= xEnd)
-            {
-                n = curvePart.size();
-                if(curvePart.size() >= 3)
-                {
-                    delta2 = fabs(curvePart[n-1].y() - curvePart[n-2].y());
-                    delta1 = fabs(curvePart[n-3].y() - curvePart[n-3].y());
-                }
-                else if(curvePart.size() == 2)
-                {
-                    delta2 = fabs(curvePart[n-1].y() - curvePart[n-2].y());
-                }
-
-                while(x <= xEnd)
-                {
-                    y = evalFunc(i, view.viewToUnit_x(x), k);
-
-                    if(std::isnan(y) || std::isinf(y))
-                    {
-                        if(!curvePart.isEmpty())
-                        {
-                            funcCurves[i][k_pos] << curvePart;
-                            curvePart.clear();
-                        }
-                    }
-                    else
-                    {
-                        curvePart << QPointF(x ,  view.unitToView_y(y) );
-                        n = curvePart.size();
-
-                        if(n > 1)
-                            delta3 = fabs(curvePart[n-1].y() - curvePart[n-2].y());
-
-                        if(n > 2 && delta2 > 4*delta1 && delta2 > 4*delta3)
-                        {
-                            pt2 = curvePart.takeLast();
-                            pt1 = curvePart.takeLast();
-
-                            funcCurves[i][k_pos] << curvePart;
-                            curvePart.clear();
-                            curvePart << pt1 << pt2;
-                        }
-
-                        delta1 = delta2;
-                        delta2 = delta3;
-                    }
-
-                    x += unitStep;
-                }
+                for(int p = first ; p < added.size() ; p++)
+                    curve.append(added.at(p), p == 0 || added.isBreak(p));
             }
             else
             {
-                while(x > xEnd)
-                {
-                    if(curvePart.isEmpty())
-                        curvePart = funcCurves[i][k_pos].takeLast();
-                    curvePart.removeLast();
-                    x -= unitStep;
-                }
+                while(!curve.isEmpty() && (curve.size() == 1 || curve.isBreak(curve.size()-1) ? curve.last().x() > xEnd : curve.at(curve.size()-2).x() >= xEnd))
+                    curve.removeLast();
             }
-
-            if(!curvePart.isEmpty())
-                funcCurves[i][k_pos] << curvePart;
-
-            k += k_step;
         }
     }
 }
@@ -299,5 +508,25 @@ int FuncValuesSaver::getFuncDrawsNum(int func)
 
 QList<QPolygonF> FuncValuesSaver::getCurve(int func, int curve)
 {
-    return funcCurves[func][curve];
+    return funcCurves[func][curve].toPolygons();
+}
+
+QList< QList<CurveBuffer> > FuncValuesSaver::getCurves()
+{
+    return funcCurves;
+}
+
+double FuncValuesSaver::getSampledStart()
+{
+    return graphView.viewRect().left() - unitStep;
+}
+
+double FuncValuesSaver::getSampledEnd()
+{
+    return graphView.viewRect().right() + unitStep;
+}
+
+int FuncValuesSaver::getCalculationId()
+{
+    return calculationId;
 }
@@ -26,6 +26,21 @@
 #define FUNCVALUESSAVER_H
 
 #include "information.h"
+#include "Calculus/curvebuffer.h"
+
+#define ADAPTIVE_MAX_DEPTH 10 // bisections of a sampling step to follow a steep part, or to find a discontinuity or the domain's end
+#define REFINE_PIXELS 2 // larger vertical gaps between consecutive points are subdivided
+#define ADAPTIVE_EVALUATIONS_PER_SAMPLE 6 // refinement budget of a curve, per evenly spaced sample: at worst 7 evaluations per sample instead of 1
+#define DECIMATION_PIXELS 0.25 // points closer than that to the chord of their neighbours are dropped
+#define MAX_DECIMATED_POINTS 64 // bounds the points a single chord can replace
+
+struct SamplingJob // one curve of a function, sampled by a thread of the pool
+{
+    int func, kPos;
+    double k;
+    int evaluationsLeft; // refinement stops there, oscillating functions would otherwise bisect every step
+    CurveBuffer curve;
+};
 
 class FuncValuesSaver
 {
@@ -33,11 +48,16 @@ public:
     FuncValuesSaver(QList<FuncCalculator *> funcsList, double pxStep);
 
     void setPixelStep(double pxStep);
-    void calculateAll(double new_xUnit, double new_yUnit, ZeGraphView view);
+    bool calculateAll(double new_xUnit, double new_yUnit, ZeGraphView view, const QAtomicInt *cancelled = NULL);
+    bool isSampledAt(double new_xUnit, double new_yUnit, ZeGraphView view); // the curves' abscissas stay valid: only edited functions are sampled again
     void move(ZeGraphView view);
     int getFuncDrawsNum(int func);
 
     QList<QPolygonF> getCurve(int func, int curve);
+    QList< QList<CurveBuffer> > getCurves();
+    double getSampledStart();
+    double getSampledEnd();
+    int getCalculationId();
 
 
 
@@ -46,15 +66,37 @@ protected slots:
 
 protected:
     void calculateAllFuncColors();
-    double evalFunc(int funId, double x, double k);
+    void fillXValues(double xFrom, double xTo, double step);
+    void sampleCurve(SamplingJob &job);
+    CurveBuffer sampleRange(int func, double k, double xFrom, double xTo);
+    void refineSegment(SamplingJob &job, QPointF a, QPointF b, int depth, QPolygonF &curvePart);
+    void extendToDomainBoundary(SamplingJob &job, QPointF defined, double undefinedX, QPolygonF &curvePart);
+    void endCurvePart(SamplingJob &job, QPolygonF &curvePart);
+    double evalViewPoint(SamplingJob &job, double xView);
+    double clampToView(double yView);
+    void addToSamplingOrder(int funId, QList<int> &visited);
+    QVector<int> getDependencies(int funId);
+    bool isCancelled();
 
     Information *information;
     ZeGraphView graphView;
     QList<FuncCalculator*> funcs;
+    QList<int> samplingOrder; // called functions come first so their callers can reuse their samples
 
     double xUnit, yUnit, pixelStep, unitStep;
+    int calculationId; // tells apart curves moved from the previous ones from newly calculated ones
+    const QAtomicInt *cancelFlag; // while calculateAll() runs, a set flag makes it give up as soon as possible
+
+    QVector<double> xViewVals, xVals; // columns sampled in one batch: view abscissas and unit abscissas
+
+    QList< QList<CurveBuffer> > funcCurves;
 
-    QList< QList< QList<QPolygonF> > > funcCurves;
+    /* What each function's curves were last completely sampled from: the revision of every function
+       it depends on, -1 for the others, with the view and scales below. Only the functions where
+       any of that changed are sampled again, an empty vector forces it. */
+    QList< QVector<int> > sampledDependencies;
+    QRectF sampledRect;
+    double sampledXUnit, sampledYUnit, sampledPixelStep;
     QList< QList<QColor> > funcColors;
 };
 
@@ -0,0 +1,160 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#include "Calculus/funcvaluesworker.h"
+
+FuncValuesWorker::FuncValuesWorker(QList<FuncCalculator *> funcsList) : saver(funcsList, 1), publishedSaver(funcsList, 1)
+{
+    request = NO_REQUEST;
+    running = quitting = upToDate = false;
+    xUnit = yUnit = pixelStep = 1;
+}
+
+FuncValuesWorker::~FuncValuesWorker()
+{
+    mutex.lock();
+    quitting = true;
+    cancelled.store(1);
+    requestCondition.wakeOne();
+    mutex.unlock();
+
+    wait();
+}
+
+void FuncValuesWorker::recalculate(double new_xUnit, double new_yUnit, ZeGraphView newView, double pxStep)
+{
+    QMutexLocker locker(&mutex);
+
+    xUnit = new_xUnit;
+    yUnit = new_yUnit;
+    view = newView;
+    pixelStep = pxStep;
+
+    request = RECALCULATE_REQUEST;
+    cancelled.store(1); // the pass in progress is for an outdated view
+
+    requestCondition.wakeOne();
+}
+
+void FuncValuesWorker::move(ZeGraphView newView)
+{
+    QMutexLocker locker(&mutex);
+
+    view = newView; // a pending recalculation takes the new view too
+
+    if(request == NO_REQUEST)
+        request = MOVE_REQUEST;
+
+    requestCondition.wakeOne();
+}
+
+void FuncValuesWorker::stop()
+{
+    QMutexLocker locker(&mutex);
+
+    request = NO_REQUEST;
+    cancelled.store(1);
+
+    while(running)
+        idleCondition.wait(&mutex);
+}
+
+void FuncValuesWorker::getCurves(FuncValuesSaver *funcValuesSaver)
+{
+    QMutexLocker locker(&mutex);
+    *funcValuesSaver = publishedSaver; // the curves are implicitly shared, nothing is copied
+}
+
+void FuncValuesWorker::publish()
+{
+    mutex.lock();
+    publishedSaver = saver;
+    mutex.unlock();
+
+    emit curvesReady();
+}
+
+void FuncValuesWorker::run()
+{
+    short task;
+    double taskXUnit, taskYUnit, taskPixelStep;
+    ZeGraphView taskView;
+
+    forever
+    {
+        mutex.lock();
+
+        running = false;
+        idleCondition.wakeAll();
+
+        while(request == NO_REQUEST && !quitting)
+            requestCondition.wait(&mutex);
+
+        if(quitting)
+        {
+            mutex.unlock();
+            return;
+        }
+
+        task = request;
+        taskXUnit = xUnit;
+        taskYUnit = yUnit;
+        taskPixelStep = pixelStep;
+        taskView = view;
+
+        request = NO_REQUEST;
+        running = true;
+        cancelled.store(0);
+
+        mutex.unlock();
+
+        if(task == MOVE_REQUEST && upToDate)
+        {
+            saver.move(taskView);
+            publish();
+        }
+        else // also when the last recalculation was cancelled: there is nothing complete to move
+        {
+            upToDate = false;
+
+            /* The preview is only worth it for a new view: when just some functions were edited, a pass at another
+               step would make the saver sample every curve again, twice, instead of only the edited ones. */
+            if(taskPixelStep < PREVIEW_PIXEL_STEP && !saver.isSampledAt(taskXUnit, taskYUnit, taskView))
+            {
+                saver.setPixelStep(PREVIEW_PIXEL_STEP);
+
+                if(saver.calculateAll(taskXUnit, taskYUnit, taskView, &cancelled))
+                    publish();
+            }
+
+            saver.setPixelStep(taskPixelStep);
+
+            if(cancelled.load() == 0 && saver.calculateAll(taskXUnit, taskYUnit, taskView, &cancelled))
+            {
+                upToDate = true;
+                publish();
+            }
+        }
+    }
+}
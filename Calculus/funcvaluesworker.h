@@ -0,0 +1,77 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#ifndef FUNCVALUESWORKER_H
+#define FUNCVALUESWORKER_H
+
+#include "Calculus/funcvaluessaver.h"
+
+#define PREVIEW_PIXEL_STEP 8 // after a view change, curves are first sampled every 8 pixels, then at the configured step
+
+#define NO_REQUEST 0
+#define RECALCULATE_REQUEST 1
+#define MOVE_REQUEST 2
+
+/* Samples the functions' curves in the background for MainGraph, so that the window stays responsive
+   whatever the expressions cost. The curves are computed on a FuncValuesSaver of its own, each finished
+   pass is copied to publishedSaver and announced with curvesReady(): for a new view a coarse preview first, then the
+   full resolution curves. A new view cancels the pass in progress, translations are handled with
+   FuncValuesSaver::move() once the curves are up to date. */
+
+class FuncValuesWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    FuncValuesWorker(QList<FuncCalculator*> funcsList);
+    ~FuncValuesWorker();
+
+    void recalculate(double new_xUnit, double new_yUnit, ZeGraphView newView, double pxStep);
+    void move(ZeGraphView newView);
+    void getCurves(FuncValuesSaver *funcValuesSaver);
+
+signals:
+    void curvesReady();
+
+public slots:
+    void stop(); // must be called before the functions are modified, waits for the computation to give up
+
+protected:
+    void run();
+    void publish();
+
+    FuncValuesSaver saver, publishedSaver;
+
+    QMutex mutex; // protects everything below, except cancelled which is read while sampling
+    QWaitCondition requestCondition, idleCondition;
+    QAtomicInt cancelled;
+    short request;
+    bool running, quitting;
+    double xUnit, yUnit, pixelStep;
+    ZeGraphView view;
+
+    bool upToDate; // only used by the worker thread: saver's curves are complete, so they can be moved
+};
+
+#endif // FUNCVALUESWORKER_H
@@ -0,0 +1,233 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+#include "Calculus/jitcompiler.h"
+#include "Calculus/bytecodeevaluator.h"
+
+#if defined(__x86_64__) && (defined(Q_OS_LINUX) || defined(Q_OS_MAC))
+#define JIT_SUPPORTED
+#include <sys/mman.h>
+#endif
+
+QHash<QByteArray, NativeByteCode> JitCompiler::programs;
+QMutex JitCompiler::programsMutex;
+
+/* Registers: rbx holds the stack pointer given as first argument, the variable and k are kept at
+   [rsp] and [rsp+8] since calls to the reference functions don't preserve the xmm registers.
+   Slot i of the stack is at [rbx + 8*i], temporary slots come right after the stack. */
+
+static void appendInt32(QByteArray &out, qint32 value)
+{
+    out.append(reinterpret_cast<const char*>(&value), 4);
+}
+
+static void appendInt64(QByteArray &out, qint64 value)
+{
+    out.append(reinterpret_cast<const char*>(&value), 8);
+}
+
+static void appendBytes(QByteArray &out, const char *bytes, int size)
+{
+    out.append(bytes, size);
+}
+
+static void loadSlot(QByteArray &out, int slot, int xmm) // movsd xmm, [rbx + 8*slot]
+{
+    appendBytes(out, "\xF2\x0F\x10", 3);
+    out.append(char(0x83 | (xmm << 3)));
+    appendInt32(out, 8*slot);
+}
+
+static void storeSlot(QByteArray &out, int slot) // movsd [rbx + 8*slot], xmm0
+{
+    appendBytes(out, "\xF2\x0F\x11\x83", 4);
+    appendInt32(out, 8*slot);
+}
+
+static void operateOnSlot(QByteArray &out, char opcode, int slot) // addsd/subsd/mulsd/divsd xmm0, [rbx + 8*slot]
+{
+    appendBytes(out, "\xF2\x0F", 2);
+    out.append(opcode);
+    out.append(char(0x83));
+    appendInt32(out, 8*slot);
+}
+
+static void callFunction(QByteArray &out, const void *function) // mov rax, function ; call rax
+{
+    appendBytes(out, "\x48\xB8", 2);
+    appendInt64(out, qint64(reinterpret_cast<quintptr>(function)));
+    appendBytes(out, "\xFF\xD0", 2);
+}
+
+NativeByteCode JitCompiler::compile(const ByteCode &code)
+{
+#ifdef JIT_SUPPORTED
+    if(code.instructions.isEmpty() || !isCompilable(code))
+        return NULL;
+
+    // fields are serialized one by one: the padding after ByteCodeInstr::type is never initialized
+    QByteArray key;
+    QDataStream keyStream(&key, QIODevice::WriteOnly);
+
+    keyStream << qint32(code.stackSize);
+
+    for(int i = 0 ; i < code.instructions.size() ; i++)
+        keyStream << code.instructions[i].type << code.instructions[i].value;
+
+    QMutexLocker locker(&programsMutex);
+
+    if(programs.contains(key))
+        return programs.value(key);
+
+    if(programs.size() >= JIT_MAX_PROGRAMS)
+        return NULL;
+
+    NativeByteCode program = install(generate(code));
+    programs.insert(key, program);
+
+    return program;
+#else
+    Q_UNUSED(code);
+    return NULL;
+#endif
+}
+
+bool JitCompiler::isCompilable(const ByteCode &code)
+{
+    for(int i = 0 ; i < code.instructions.size() ; i++)
+    {
+        short type = code.instructions[i].type;
+
+        bool compilable = type == NUMBER || type == POW || (VARS_START < type && type <= LOAD_TMP) ||
+                          (REF_FUNC_START < type && type < REF_FUNC_END);
+
+        if(!compilable)
+            return false;
+    }
+
+    return true;
+}
+
+QByteArray JitCompiler::generate(const ByteCode &code)
+{
+    QByteArray out;
+    int depth = 0;
+
+    // push rbx ; sub rsp, 16 ; mov rbx, rdi ; movsd [rsp], xmm0 ; movsd [rsp+8], xmm1
+    appendBytes(out, "\x53\x48\x83\xEC\x10\x48\x89\xFB\xF2\x0F\x11\x04\x24\xF2\x0F\x11\x4C\x24\x08", 19);
+
+    for(int i = 0 ; i < code.instructions.size() ; i++)
+    {
+        const ByteCodeInstr &instr = code.instructions[i];
+
+        switch(instr.type)
+        {
+        case NUMBER:
+            appendBytes(out, "\x48\xB8", 2); // mov rax, value ; mov [rbx + 8*depth], rax
+            out.append(reinterpret_cast<const char*>(&instr.value), 8);
+            appendBytes(out, "\x48\x89\x83", 3);
+            appendInt32(out, 8*depth);
+            depth++;
+            break;
+        case VAR_X:
+        case VAR_T:
+        case VAR_N:
+            appendBytes(out, "\xF2\x0F\x10\x04\x24", 5); // movsd xmm0, [rsp]
+            storeSlot(out, depth);
+            depth++;
+            break;
+        case PAR_K:
+            appendBytes(out, "\xF2\x0F\x10\x44\x24\x08", 6); // movsd xmm0, [rsp+8]
+            storeSlot(out, depth);
+            depth++;
+            break;
+        case PLUS:
+        case MINUS:
+        case MULTIPLY:
+        case DIVIDE:
+            depth--;
+            loadSlot(out, depth-1, 0);
+            operateOnSlot(out, instr.type == PLUS ? 0x58 : instr.type == MINUS ? 0x5C : instr.type == MULTIPLY ? 0x59 : 0x5E, depth);
+            storeSlot(out, depth-1);
+            break;
+        case POW:
+            depth--;
+            loadSlot(out, depth-1, 0);
+            loadSlot(out, depth, 1);
+            callFunction(out, reinterpret_cast<const void*>(static_cast<double (*)(double, double)>(pow)));
+            storeSlot(out, depth-1);
+            break;
+        case SQUARE:
+            loadSlot(out, depth-1, 0);
+            appendBytes(out, "\xF2\x0F\x59\xC0", 4); // mulsd xmm0, xmm0
+            storeSlot(out, depth-1);
+            break;
+        case CUBE:
+            loadSlot(out, depth-1, 0);
+            appendBytes(out, "\x66\x0F\x28\xC8\xF2\x0F\x59\xC0\xF2\x0F\x59\xC1", 12); // movapd xmm1, xmm0 ; mulsd xmm0, xmm0 ; mulsd xmm0, xmm1
+            storeSlot(out, depth-1);
+            break;
+        case STORE_TMP:
+            loadSlot(out, depth-1, 0);
+            storeSlot(out, code.stackSize + int(instr.value));
+            break;
+        case LOAD_TMP:
+            loadSlot(out, code.stackSize + int(instr.value), 0);
+            storeSlot(out, depth);
+            depth++;
+            break;
+        default: // reference function, see isCompilable()
+            loadSlot(out, depth-1, 0);
+            callFunction(out, reinterpret_cast<const void*>(ByteCodeEvaluator::getRefFunc(instr.type)));
+            storeSlot(out, depth-1);
+        }
+    }
+
+    appendBytes(out, "\x48\x83\xC4\x10\x5B\xC3", 6); // add rsp, 16 ; pop rbx ; ret
+
+    return out;
+}
+
+NativeByteCode JitCompiler::install(const QByteArray &machineCode)
+{
+#ifdef JIT_SUPPORTED
+    size_t size = machineCode.size();
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if(memory == MAP_FAILED)
+        return NULL;
+
+    memcpy(memory, machineCode.constData(), size);
+
+    if(mprotect(memory, size, PROT_READ | PROT_EXEC) != 0)
+    {
+        munmap(memory, size);
+        return NULL;
+    }
+
+    return reinterpret_cast<NativeByteCode>(memory);
+#else
+    Q_UNUSED(machineCode);
+    return NULL;
+#endif
+}
@@ -0,0 +1,53 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#ifndef JITCOMPILER_H
+#define JITCOMPILER_H
+
+#include "structures.h"
+
+#define JIT_MAX_PROGRAMS 1024 // beyond, new programs stay interpreted
+
+/* Translates bytecode programs into x86-64 machine code, each instruction becoming a few SSE2
+   instructions working on the same stack layout as ByteCodeEvaluator::evaluateStack, so that both
+   give the same results. Only programs made of numbers, variables and reference functions are
+   compiled: calls to other math objects need the calculators and stay interpreted.
+   Compiled programs are shared by every expression compiling to the same bytecode and live until
+   the application quits. compile() returns NULL when the program, or the platform, isn't supported. */
+
+class JitCompiler
+{
+public:
+    static NativeByteCode compile(const ByteCode &code);
+
+protected:
+    static bool isCompilable(const ByteCode &code);
+    static QByteArray generate(const ByteCode &code);
+    static NativeByteCode install(const QByteArray &machineCode);
+
+    static QHash<QByteArray, NativeByteCode> programs;
+    static QMutex programsMutex;
+};
+
+#endif // JITCOMPILER_H
@@ -23,16 +23,14 @@
 
 
 #include "Calculus/seqcalculator.h"
-
-static double tenPower(double x)
-{
-     return pow(10, x);
-}
+#include <QtConcurrent>
+#include <numeric>
 
 SeqCalculator::SeqCalculator(int id, QString name, QLabel *errorLabel) : treeCreator(SEQUENCE), firstValsTreeCreator(NORMAL_EXPR)
 {   
     seqNum = id;
     isExprValidated = isValid = isKRangeValid = blockCalculatingFromTree = false;
+    callsOtherSeqs = computingRows = false;
     errorMessageLabel = errorLabel;
 
     areFirstValsValidated = true;    
@@ -42,8 +40,6 @@ SeqCalculator::SeqCalculator(int id, QString name, QLabel *errorLabel) : treeCre
     k = 0;
     drawState = true;
 
-    addRefFuncsPointers();
-
     firstValsTreeCreator.allow_k(true);
     kRange.start = 0;
     kRange.step = 1;
@@ -51,7 +47,7 @@ SeqCalculator::SeqCalculator(int id, QString name, QLabel *errorLabel) : treeCre
 
     seqsNames << "(u<sub>n</sub>)" << "(v<sub>n</sub>)" << "(l<sub>n</sub>)" << "(w<sub>n</sub>)" << "(q<sub>n</sub>)" << "(z<sub>n</sub>)";
 
-    seqValues << QList<double>();
+    seqValues << QVector<double>();
 
     seqName =  name;
 }
@@ -75,10 +71,11 @@ bool SeqCalculator::validateSeqExpr(QString expr)
     drawsNum = 1;
     seqValues.clear();
 
-    if(seqTree != NULL)
-        treeCreator.deleteFastTree(seqTree);
+    seqCode = treeCreator.getByteCodeFromExpr(expr, isExprValidated);
 
-    seqTree = treeCreator.getTreeFromExpr(expr, isExprValidated);
+    callsOtherSeqs = false;
+    for(int id : treeCreator.getCalledSeqs(expr))
+        callsOtherSeqs = callsOtherSeqs || id != seqNum;
 
     return isExprValidated;
 }
@@ -227,9 +224,9 @@ bool SeqCalculator::saveCustomSeqValues(double nMax)
 
     if(seqValues[kPos].size() == 0)
     {
-        for(int i = 0; i < firstValsTrees.size(); i++)
+        for(int i = 0; i < firstValsCodes.size(); i++)
         {
-            result = calculateFromTree(firstValsTrees[i],i, ok);
+            result = evaluateByteCode(firstValsCodes[i], i, k, ok);
 
             if(!ok)
                 return false;
@@ -240,7 +237,7 @@ bool SeqCalculator::saveCustomSeqValues(double nMax)
 
     for(int n = seqValues[kPos].size() + nMin; n <= nMax + nMin; n++)
     {
-        result = calculateFromTree(seqTree, n, ok);
+        result = evaluateByteCode(seqCode, n, k, ok);
 
         if(!ok)
             return false;
@@ -272,12 +269,37 @@ double SeqCalculator::getSeqValue(double n, bool &ok, int index_k)
     else return NAN;
 }
 
+QVector<double> SeqCalculator::getSeqValues(int nStart, int nEnd, int step, bool &ok, int index_k)
+{
+    QVector<double> values;
+
+    if(nStart < nMin || nEnd > MAX_SAVED_SEQ_VALS || nStart > nEnd || step <= 0 || index_k < 0 || index_k >= drawsNum)
+        return values;
+
+    if(nEnd-nMin >= seqValues[0].size())
+    {
+        ok = isValid = saveSeqValues(nEnd);
+        blockCalculatingFromTree = false;
+    }
+
+    if(!ok)
+        return values;
+
+    const QVector<double> &row = seqValues.at(index_k);
+    values.reserve((nEnd - nStart) / step + 1);
+
+    for(int n = nStart ; n <= nEnd ; n += step)
+        values << row.at(n - nMin);
+
+    return values;
+}
+
 void SeqCalculator::updateSeqValuesSize()
 {
     int size = trunc((kRange.end - kRange.start)/kRange.step) + 2;
 
     for(int i = seqValues.size() ; i < size ; i++)
-        seqValues << QList<double>();
+        seqValues << QVector<double>();
 }
 
 bool SeqCalculator::saveSeqValues(double nMax)
@@ -290,59 +312,111 @@ bool SeqCalculator::saveSeqValues(double nMax)
     }
 
     blockCalculatingFromTree = true;
-    bool ok = true;
 
     if(nMax > MAX_SAVED_SEQ_VALS + nMin)
         nMax = MAX_SAVED_SEQ_VALS + nMin;
 
-    double result;
+    double newTerms = (nMax + 1 - seqValues[0].size()) * drawsNum;
+
+    if(drawsNum > 1 && !callsOtherSeqs && newTerms >= SEQ_PARALLEL_MIN_TERMS)
+    {
+        QVector<double> *rows = seqValues.data(); // detached once here, the rows are then only read and appended by their own thread
+        QVector<int> rowsIndexes(drawsNum);
+        std::iota(rowsIndexes.begin(), rowsIndexes.end(), 0);
+        QAtomicInt failed(0);
+
+        rowsError.clear();
+        computingRows = true;
 
-    k = kRange.start;
+        QtConcurrent::blockingMap(rowsIndexes, [this, rows, nMax, &failed](int row)
+        {
+            if(!failed.load() && !saveRowValues(rows[row], kValue(row), nMax))
+                failed.ref();
+        });
+
+        computingRows = false;
+
+        if(!rowsError.isEmpty())
+            errorMessageLabel->setText(rowsError);
+
+        return !failed.load();
+    }
 
     for(kPos = 0; kPos < drawsNum; kPos++)
     {
-        for(int n = seqValues[kPos].size() + nMin; n <= nMax + nMin; n++)
-        {
-            result = calculateFromTree(seqTree, n, ok);
+        if(!saveRowValues(seqValues[kPos], kValue(kPos), nMax))
+            return false;
+    }
 
-            if(!ok)
-                return false;
+    return true;
+}
 
-            seqValues[kPos] << result;
-        }
+bool SeqCalculator::saveRowValues(QVector<double> &values, double k_val, double nMax)
+{
+    bool ok = true;
+    double result;
 
-        k += kRange.step;
+    if(values.capacity() < nMax + 1)
+        values.reserve(qMax(int(nMax) + 1, 2 * values.capacity()));
+
+    for(int n = values.size() + nMin; n <= nMax + nMin; n++)
+    {
+        result = evaluateByteCode(seqCode, n, k_val, ok);
+
+        if(!ok)
+            return false;
+
+        values << result;
     }
 
     return true;
 }
 
+int SeqCalculator::rowOf(double k_val)
+{
+    return qRound((k_val - kRange.start) / kRange.step);
+}
+
+double SeqCalculator::kValue(int row)
+{
+    return kRange.start + row * kRange.step;
+}
+
+void SeqCalculator::setError(const QString &message)
+{
+    if(computingRows)
+    {
+        QMutexLocker locker(&rowsErrorMutex);
+        rowsError = message;
+    }
+    else errorMessageLabel->setText(message);
+}
+
 bool SeqCalculator::calculateAndSaveFirstValuesTrees()
 {
     updateSeqValuesSize();
 
-    if(seqValues[0].size() >= firstValsTrees.size())
+    if(seqValues[0].size() >= firstValsCodes.size())
         return true;
 
     bool ok = true;
     double result = 0;
-    k = kRange.start;
 
     int savedKpos = kPos;
 
     for(kPos = 0; kPos < drawsNum; kPos++)
     {
-        for(int i = 0; i < firstValsTrees.size(); i++)
+        k = kValue(kPos);
+
+        for(int i = 0; i < firstValsCodes.size(); i++)
         {
-            result = calculateFromTree(firstValsTrees[i], 0, ok);
+            result = evaluateByteCode(firstValsCodes[i], 0, k, ok);
 
             if(!ok)
                 return false;
 
             seqValues[kPos] << result;
         }
-
-        k += kRange.step;
     }
 
     kPos = savedKpos;
@@ -350,88 +424,49 @@ bool SeqCalculator::calculateAndSaveFirstValuesTrees()
     return true;
 }
 
-double SeqCalculator::calculateFromTree(FastTree *tree, double x, bool &ok)
+double SeqCalculator::callMathObject(short type, double arg, double k_val, bool &ok)
 {
-    if(!ok)
-        return NAN;
-    if(tree->type == NUMBER )
-    {
-        return *tree->value;
-    }
-    else if(tree->type == VAR_N)
-    {
-        return x;
-    }
-    else if(tree->type == PAR_K)
-    {
-        return k;
-    }
-    else if(tree->type == PLUS)
+    if(FUNC_START < type && type < FUNC_END)
     {
-        return calculateFromTree(tree->left, x, ok) + calculateFromTree(tree->right, x, ok);
+        int id = type - FUNC_START - 1;
+        return funcCalculatorsList[id]->getCachedFuncValue(arg, k_val);
     }
-    else if(tree->type == MINUS)
+    else if(DERIV_START < type && type < DERIV_END)
     {
-        return calculateFromTree(tree->left, x, ok) - calculateFromTree(tree->right, x, ok);
+        int id = type - DERIV_START - 1;
+        return funcCalculatorsList[id]->getDerivativeValue(arg, k_val);
     }
-    else if(tree->type == MULTIPLY)
+    else if(type == seqNum + SEQUENCES_START + 1)
     {
-        return calculateFromTree(tree->left, x, ok) * calculateFromTree(tree->right, x, ok);
-    }
-    else if(tree->type == DIVIDE)
-    {
-        return calculateFromTree(tree->left, x, ok) / calculateFromTree(tree->right, x, ok);
-    }
-    else if(tree->type == POW)
-    {
-        return pow(calculateFromTree(tree->left, x, ok), calculateFromTree(tree->right, x, ok));
-    }
-    else if(REF_FUNC_START < tree->type && tree->type < REF_FUNC_END)
-    {
-        return (*refFuncs[tree->type - REF_FUNC_START - 1])(calculateFromTree(tree->right, x, ok));
-    }
-    else if(FUNC_START < tree->type && tree->type < FUNC_END)
-    {
-        int id = tree->type - FUNC_START - 1;
-        return funcCalculatorsList[id]->getFuncValue(calculateFromTree(tree->right, x, ok), k);
-    }
-    else if(DERIV_START < tree->type && tree->type < DERIV_END)
-    {
-        int id = tree->type - DERIV_START - 1;
-        return funcCalculatorsList[id]->getDerivativeValue(calculateFromTree(tree->right, x, ok), k);
-    }
-    else if(tree->type == seqNum + SEQUENCES_START + 1)
-    {
-        double asked_n = calculateFromTree(tree->right, x, ok);
-        ok = verifyAskedTerm(asked_n);
+        int row = computingRows ? rowOf(k_val) : kPos;
+        ok = verifyAskedTerm(arg, row);
         if(ok)
-            return seqValues[kPos][asked_n];
+            return seqValues.at(row).at(arg - nMin);
         else return NAN;
     }
-    else if(SEQUENCES_START < tree->type && tree->type < SEQUENCES_END)
+    else if(SEQUENCES_START < type && type < SEQUENCES_END)
     {
-        int id = tree->type - SEQUENCES_START - 1;
-        double asked_n = calculateFromTree(tree->right, x, ok);
-        ok = verifyOtherSeqAskedTerm(asked_n, id);
+        int id = type - SEQUENCES_START - 1;
+        ok = verifyOtherSeqAskedTerm(arg, id);
         if(ok)
-            return seqCalculatorsList[id]->getCustomSeqValue(asked_n, ok, k);
+            return seqCalculatorsList[id]->getCustomSeqValue(arg, ok, k_val);
         else return NAN;
     }
 
     else return NAN;
 }
 
-bool SeqCalculator::verifyAskedTerm(double n)
+bool SeqCalculator::verifyAskedTerm(double n, int row)
 {
-    if(ceil(n) != n || n-nMin >= seqValues[kPos].size())
+    if(ceil(n) != n || n-nMin >= seqValues.at(row).size())
     {
-        errorMessageLabel->setText(tr("Invalid recursion."));
+        setError(tr("Invalid recursion."));
 
         return false;       
     }
     else if(n < nMin)
     {
-        errorMessageLabel->setText(tr("Insufficient number of entered first values."));
+        setError(tr("Insufficient number of entered first values."));
 
         return false;
     }
@@ -455,15 +490,6 @@ bool SeqCalculator::verifyOtherSeqAskedTerm(double n, int id)
     else return true;
 }
 
-void SeqCalculator::addRefFuncsPointers()
-{
-    refFuncs << acos << asin << atan << cos << sin << tan << sqrt
-             << log10 << log << fabs << exp << floor << ceil << cosh
-             << sinh << tanh << tenPower << tenPower << acosh << asinh
-             << atanh << erf << erfc << tgamma << tgamma << cosh
-             << sinh << tanh << acosh << asinh << atanh;
-}
-
 bool SeqCalculator::check_called_funcs_and_seqs_validity()
 {
     isValid = checkCalledFuncsValidity(expression);
@@ -532,14 +558,14 @@ bool SeqCalculator::canBeCalled()
 
 bool SeqCalculator::validateSeqFirstValsTrees()
 {
-    deleteFirstValsTrees();
+    firstValsCodes.clear();
 
     if(firstValsExpr.isEmpty())
         return true;
 
     firstValsExpr.remove(" ");
     QString str;
-    FastTree *tree;
+    ByteCode code;
 
     bool ok = true;
 
@@ -548,23 +574,13 @@ bool SeqCalculator::validateSeqFirstValsTrees()
     for(short i = 0; i < count; i++)
     {
         str = firstValsExpr.section(';', i, i);
-        tree = treeCreator.getTreeFromExpr(str, ok);
+        code = treeCreator.getByteCodeFromExpr(str, ok);
 
         if(!ok)
             return false;
 
-        firstValsTrees << tree;
+        firstValsCodes << code;
     }
 
     return true;
 }
-
-void SeqCalculator::deleteFirstValsTrees()
-{
-    for(int i = 0; i < firstValsTrees.size() ; i++)
-    {
-        firstValsTreeCreator.deleteFastTree(firstValsTrees[i]);
-    }
-
-    firstValsTrees.clear();
-}
@@ -29,9 +29,12 @@
 #include "structures.h"
 #include "treecreator.h"
 #include "funccalculator.h"
+#include "bytecodeevaluator.h"
 #include "colorsaver.h"
 
-class SeqCalculator : public QObject
+#define SEQ_PARALLEL_MIN_TERMS 4096 // fewer new terms, for all the k-draws together, are computed serially
+
+class SeqCalculator : public QObject, public ByteCodeEvaluator
 {
     Q_OBJECT
 
@@ -61,6 +64,7 @@ public:
 
     Range getKRange();
     double getSeqValue(double n, bool &ok, int index_k = 0);
+    QVector<double> getSeqValues(int nStart, int nEnd, int step, bool &ok, int index_k = 0); // terms nStart, nStart + step... up to nEnd
     double getCustomSeqValue(double n, bool &ok, double k_value);
 
 public slots:
@@ -72,38 +76,47 @@ signals:
 
 protected:
 
-    void addRefFuncsPointers(); 
-    void deleteFirstValsTrees();
     bool checkCalledFuncsValidity(QString str);
     bool checkCalledSeqsValidity(QString str);
     bool calculateAndSaveFirstValuesTrees();
     void updateSeqValuesSize();
 
-    double calculateFromTree(FastTree *tree, double n, bool &ok);
+    double callMathObject(short type, double arg, double k_val, bool &ok);
 
     bool validateSeqFirstValsTrees();
     bool saveSeqValues(double nMax);
+    bool saveRowValues(QVector<double> &values, double k_val, double nMax);
+    int rowOf(double k_val);
+    double kValue(int row);
+    void setError(const QString &message);
     bool saveCustomSeqValues(double nMax);
-    bool verifyAskedTerm(double n);
+    bool verifyAskedTerm(double n, int row);
     bool verifyOtherSeqAskedTerm(double n, int id);
 
     QLabel *errorMessageLabel;
 
     int seqNum, kPos, nMin, drawsNum;
     bool isExprValidated, areFirstValsValidated, isParametric, isValid, blockCalculatingFromTree, drawState, isKRangeValid;
+    bool callsOtherSeqs;
     double custom_k, k;
     ColorSaver *colorSaver;
     Range kRange;
     TreeCreator treeCreator, firstValsTreeCreator;
-    FastTree *seqTree;
+    ByteCode seqCode;
     QString expression, firstValsExpr, seqName;
     QStringList seqsNames;
     QList<FuncCalculator*> funcCalculatorsList;
     QList<SeqCalculator*> seqCalculatorsList;
-    QList<double (*)(double)> refFuncs;
 
-    QList<FastTree*> firstValsTrees;
-    QList< QList<double> > seqValues;    
+    QList<ByteCode> firstValsCodes;
+    QVector< QVector<double> > seqValues; // one row of terms per k-draw, plus one for a custom k
+
+    /* When the sequence only calls itself, each k-draw only reads its own row: saveSeqValues() then
+       computes the rows in parallel, and callMathObject() finds the row from k instead of kPos.
+       Errors met meanwhile are shown once every row is done. */
+    bool computingRows;
+    QMutex rowsErrorMutex;
+    QString rowsError;
 };
 
 #endif // SEQCALCULATOR_H
@@ -24,6 +24,13 @@
 
 #include "Calculus/treecreator.h"
 
+#ifdef ZEGRAPHER_JIT
+#include "Calculus/jitcompiler.h"
+#endif
+
+QCache<QString, CompiledExprs> TreeCreator::compiledExprsCache(COMPILED_EXPRS_CACHE_SIZE);
+QMutex TreeCreator::compiledExprsMutex;
+
 TreeCreator::TreeCreator(short callingObjectType)
 {
     funcType = callingObjectType;
@@ -71,9 +78,9 @@ void TreeCreator::refreshAuthorizedVars()
     }
 }
 
-FastTree* TreeCreator::getTreeFromExpr(QString expr, bool &ok, QStringList additionnalVars)
+int TreeCreator::getTreeFromExpr(QString expr, bool &ok, QStringList additionnalVars)
 {    
-    FastTree *tree = NULL;
+    int tree = NO_CHILD;
 
     customVars = additionnalVars;
 
@@ -81,11 +88,198 @@ FastTree* TreeCreator::getTreeFromExpr(QString expr, bool &ok, QStringList addit
     ok = check(expr);
 
     if(ok)
-        tree = createFastTree(decompTypes.size()-1, 0);
+        tree = simplifyFastTree(createFastTree(decompTypes.size()-1, 0));
 
     return tree;
 }
 
+ByteCode TreeCreator::getByteCodeFromExpr(QString expr, bool &ok, QStringList additionnalVars)
+{
+    return getByteCodeFromExprs(QStringList() << expr, ok, additionnalVars);
+}
+
+ByteCode TreeCreator::getByteCodeFromExprs(QStringList exprs, bool &ok, QStringList additionnalVars)
+{
+    QString key = getCompilationKey(exprs, additionnalVars);
+
+    compiledExprsMutex.lock();
+    CompiledExprs *cached = compiledExprsCache.object(key);
+    CompiledExprs compiled = cached != NULL ? *cached : CompiledExprs();
+    compiledExprsMutex.unlock();
+
+    if(cached != NULL)
+    {
+        ok = compiled.ok;
+        return compiled.code;
+    }
+
+    QList<int> roots;
+
+    nodes.clear();
+    ok = true;
+
+    for(int i = 0 ; i < exprs.size() && ok ; i++)
+        roots << getTreeFromExpr(exprs[i], ok, additionnalVars);
+
+    if(ok)
+        compiled.code = compileFastTrees(roots);
+
+    compiled.ok = ok;
+
+    compiledExprsMutex.lock();
+    compiledExprsCache.insert(key, new CompiledExprs(compiled));
+    compiledExprsMutex.unlock();
+
+    return compiled.code;
+}
+
+QString TreeCreator::getCompilationKey(const QStringList &exprs, const QStringList &additionnalVars)
+{
+    QString key = QString::number(funcType);
+
+    for(int i = 0 ; i < authorizedVars.size() ; i++)
+        key += authorizedVars[i] ? '1' : '0';
+
+    key += '\n' + additionnalVars.join(",");
+
+    /* Spaces never make insertMultiplySigns() insert anything and check() removes them: trimming them,
+       and collapsing runs of them into one, leaves the parsing unchanged. */
+
+    for(int i = 0 ; i < exprs.size() ; i++)
+    {
+        QString expr;
+
+        for(int j = 0 ; j < exprs[i].size() ; j++)
+            if(exprs[i][j] != ' ' || (!expr.isEmpty() && !expr.endsWith(' ')))
+                expr += exprs[i][j];
+
+        if(expr.endsWith(' '))
+            expr.chop(1);
+
+        key += '\n' + expr;
+    }
+
+    return key;
+}
+
+ByteCode TreeCreator::compileFastTrees(QList<int> roots)
+{
+    /* Common subexpression elimination: structurally equal subtrees, within a tree or across the trees
+       (typically x(t) and y(t) of a parametric equation), get the same id. The first occurrence of
+       a subtree used several times saves its value in a temporary slot, the next ones reload it. */
+
+    ByteCode code;
+    QHash<FastTreeKey, int> ids;
+    int depth = 0;
+
+    nodesIds.fill(-1, nodes.size());
+    idsUses.clear();
+    idsTemps.clear();
+
+    for(int i = 0 ; i < roots.size() ; i++)
+        numberFastTree(roots[i], ids);
+
+    for(int i = 0 ; i < roots.size() ; i++)
+        countUses(roots[i]);
+
+    for(int i = 0 ; i < roots.size() ; i++)
+        appendPostfix(roots[i], code, depth);
+
+    code.outputsCount = roots.size();
+
+#ifdef ZEGRAPHER_JIT
+    code.native = JitCompiler::compile(code);
+#endif
+
+    return code;
+}
+
+int TreeCreator::numberFastTree(int tree, QHash<FastTreeKey, int> &ids)
+{
+    FastTreeKey key;
+    key.type = nodes[tree].type;
+    key.value = nodes[tree].value;
+    key.left = nodes[tree].left != NO_CHILD ? numberFastTree(nodes[tree].left, ids) : -1;
+    key.right = nodes[tree].right != NO_CHILD ? numberFastTree(nodes[tree].right, ids) : -1;
+
+    int id = ids.value(key, -1);
+
+    if(id == -1)
+    {
+        id = idsUses.size();
+        ids.insert(key, id);
+        idsUses << 0;
+        idsTemps << -1;
+    }
+
+    nodesIds[tree] = id;
+
+    return id;
+}
+
+void TreeCreator::countUses(int tree)
+{
+    int id = nodesIds[tree];
+    idsUses[id]++;
+
+    if(idsUses[id] > 1)
+        return; // the subtrees of a reloaded value are not evaluated again
+
+    if(nodes[tree].left != NO_CHILD)
+        countUses(nodes[tree].left);
+    if(nodes[tree].right != NO_CHILD)
+        countUses(nodes[tree].right);
+}
+
+void TreeCreator::appendPostfix(int tree, ByteCode &code, int &depth)
+{
+    int id = nodesIds[tree];
+    const FastTree &node = nodes[tree];
+    ByteCodeInstr instr;
+
+    if(idsTemps[id] != -1)
+    {
+        instr.type = LOAD_TMP;
+        instr.value = idsTemps[id];
+        code.instructions << instr;
+
+        depth++;
+        if(depth > code.stackSize)
+            code.stackSize = depth;
+
+        return;
+    }
+
+    if(node.left != NO_CHILD)
+        appendPostfix(node.left, code, depth);
+    if(node.right != NO_CHILD)
+        appendPostfix(node.right, code, depth);
+
+    instr.type = node.type;
+    instr.value = node.value;
+    code.instructions << instr;
+
+    if(node.left == NO_CHILD && node.right == NO_CHILD)
+    {
+        depth++; // a leaf pushes its value, there is no point in saving it
+        if(depth > code.stackSize)
+            code.stackSize = depth;
+
+        return;
+    }
+    else if(node.left != NO_CHILD && node.right != NO_CHILD)
+        depth--; // a binary operator pops two values and pushes one
+
+    if(idsUses[id] > 1)
+    {
+        idsTemps[id] = code.tempsCount++;
+
+        instr.type = STORE_TMP;
+        instr.value = idsTemps[id];
+        code.instructions << instr;
+    }
+}
+
 void TreeCreator::allow_k(bool state)
 {
     authorizedVars[3] = state;
@@ -348,27 +542,28 @@ bool TreeCreator::check(QString formula)
     return pth == 0 && canEnd;
 }
 
-FastTree* TreeCreator::createFastTree(int debut, int fin)
+int TreeCreator::newNode(short type, double value)
 {
-    FastTree *root = new FastTree;
-    root->right = NULL;
-    root->left = NULL;
-    root->value = NULL;
+    FastTree node;
+    node.type = type;
+    node.value = value;
+    node.left = node.right = NO_CHILD;
+
+    nodes << node;
 
+    return nodes.size() - 1;
+}
+
+int TreeCreator::createFastTree(int debut, int fin)
+{
     short pths = 0, closingPthPos = 0, openingPthPos = 0;
     bool debutPthFerme = false;
 
     if(debut == fin)
     {
         if(decompPriorites[debut] == NUMBER)
-        {
-            root->type = NUMBER;
-            root->value = new double;
-            *root->value = decompValues[debut];
-        }
-        else root->type = decompTypes[debut];
-
-        return root;
+            return newNode(NUMBER, decompValues[debut]);
+        else return newNode(decompTypes[debut]);
     }
 
     for(char op = 0; op < 5; op++)
@@ -391,32 +586,92 @@ FastTree* TreeCreator::createFastTree(int debut, int fin)
                 {
                     openingPthPos = i + 1;
                     if(op == PTHO)
-                    {
-                        delete root;
-                        root = createFastTree(closingPthPos, openingPthPos);
-                        return root;
-                    }
+                        return createFastTree(closingPthPos, openingPthPos);
                 }
             }
             else if(pths == 0 && decompPriorites[i] == op)
             {
-                root->type = decompTypes[i];
-                root->right = createFastTree(debut, i + 1);
+                int root = newNode(decompTypes[i]);
+                int child = createFastTree(debut, i + 1); // the arena may grow: no reference kept across
+                nodes[root].right = child;
                 if(op != FUNC)
-                    root->left = createFastTree(i - 1, fin);
+                {
+                    child = createFastTree(i - 1, fin);
+                    nodes[root].left = child;
+                }
                 return root;
             }
         }
     }
-    return root;
+    return newNode(NUMBER, NAN);
+}
+
+int TreeCreator::simplifyFastTree(int tree)
+{
+    // nothing is added to the arena here, references to its nodes stay valid
+
+    FastTree &node = nodes[tree];
+
+    if(node.left != NO_CHILD)
+        node.left = simplifyFastTree(node.left);
+    if(node.right != NO_CHILD)
+        node.right = simplifyFastTree(node.right);
+
+    bool isOperator = (PLUS <= node.type && node.type <= DIVIDE) || node.type == POW;
+    bool isRefFunc = REF_FUNC_START < node.type && node.type < REF_FUNC_END;
+
+    // constant folding: operators and reference functions whose operands are all numbers
+
+    if((isOperator && nodes[node.left].type == NUMBER && nodes[node.right].type == NUMBER) ||
+            (isRefFunc && nodes[node.right].type == NUMBER))
+    {
+        double a = isOperator ? nodes[node.left].value : 0, b = nodes[node.right].value, result;
+
+        if(node.type == PLUS)
+            result = a + b;
+        else if(node.type == MINUS)
+            result = a - b;
+        else if(node.type == MULTIPLY)
+            result = a * b;
+        else if(node.type == DIVIDE)
+            result = a / b;
+        else if(node.type == POW)
+            result = pow(a, b);
+        else result = ByteCodeEvaluator::callRefFunc(node.type, b);
+
+        node.left = node.right = NO_CHILD;
+        node.type = NUMBER;
+        node.value = result;
+
+        return tree;
+    }
+
+    // identities, they keep the exact same result, NAN included. Dropped nodes stay in the arena until it's emptied
+
+    if(node.type == PLUS && isNumber(node.left, 0))
+        return node.right;
+    else if((node.type == PLUS || node.type == MINUS) && isNumber(node.right, 0))
+        return node.left;
+    else if(node.type == MULTIPLY && isNumber(node.left, 1))
+        return node.right;
+    else if((node.type == MULTIPLY || node.type == DIVIDE || node.type == POW) && isNumber(node.right, 1))
+        return node.left;
+    else if(node.type == POW && isNumber(node.right, 0))
+    {
+        nodes[node.right].value = 1; // pow(x, 0) is 1 for every x
+        return node.right;
+    }
+    else if(node.type == POW && (isNumber(node.right, 2) || isNumber(node.right, 3)))
+    {
+        node.type = nodes[node.right].value == 2 ? SQUARE : CUBE;
+        node.right = node.left; // unary operators keep their operand on the right, like functions
+        node.left = NO_CHILD;
+    }
+
+    return tree;
 }
 
-void TreeCreator::deleteFastTree(FastTree *tree)
+bool TreeCreator::isNumber(int tree, double val)
 {
-    delete tree->value;
-    if(tree->left != NULL)
-        deleteFastTree(tree->left);
-    if(tree->right != NULL)
-        deleteFastTree(tree->right);
-    delete tree;
+    return tree != NO_CHILD && nodes[tree].type == NUMBER && nodes[tree].value == val;
 }
@@ -28,25 +28,60 @@
 
 #include "structures.h"
 #include "calculusdefines.h"
+#include "bytecodeevaluator.h"
+
+#define COMPILED_EXPRS_CACHE_SIZE 512 // expressions kept compiled, the least recently used ones are dropped
+
+struct CompiledExprs
+{
+    ByteCode code;
+    bool ok;
+};
+
+struct FastTreeKey // identifies structurally equal subtrees, children are referred to by their id
+{
+    short type;
+    double value;
+    int left, right;
+
+    bool operator==(const FastTreeKey &other) const
+    {
+        return type == other.type && value == other.value && left == other.left && right == other.right;
+    }
+};
+
+inline uint qHash(const FastTreeKey &key, uint seed = 0)
+{
+    return qHash(int(key.type), seed) ^ qHash(key.value, seed) ^ qHash(key.left, seed + 1) ^ qHash(key.right, seed + 2);
+}
 
 class TreeCreator
 {
 public:
     TreeCreator(short callingObjectType);
 
-    FastTree* getTreeFromExpr(QString expr, bool &ok, QStringList additionnalVars = QStringList());
+    ByteCode getByteCodeFromExpr(QString expr, bool &ok, QStringList additionnalVars = QStringList());
+    ByteCode getByteCodeFromExprs(QStringList exprs, bool &ok, QStringList additionnalVars = QStringList());
 
     QList<int> getCalledFuncs(QString expr);
     QList<int> getCalledSeqs(QString expr);
 
     void allow_k(bool state);
-    void deleteFastTree(FastTree *tree);    
 
 protected:
     bool check(QString formula);    
     void insertMultiplySigns(QString &formula);
     void refreshAuthorizedVars();
-    FastTree* createFastTree(int debut, int fin);
+    QString getCompilationKey(const QStringList &exprs, const QStringList &additionnalVars);
+    int getTreeFromExpr(QString expr, bool &ok, QStringList additionnalVars);
+    ByteCode compileFastTrees(QList<int> roots);
+    int newNode(short type, double value = 0);
+    int createFastTree(int debut, int fin);
+    int simplifyFastTree(int tree);
+    bool isNumber(int tree, double val);
+    void appendPostfix(int tree, ByteCode &code, int &depth);
+    int numberFastTree(int tree, QHash<FastTreeKey, int> &ids);
+    void countUses(int tree);
 
     short funcType;
     QStringList refFunctions, functions, sequences, antiderivatives, derivatives, constants, vars, customVars;
@@ -58,6 +93,18 @@ protected:
     QList<bool> authorizedVars;
     QString pi;
 
+    /* Shared by every TreeCreator: the same text, with the same allowed variables, always compiles to
+       the same code, so validating again an expression, or pasting it elsewhere, skips the parsing. */
+    static QCache<QString, CompiledExprs> compiledExprsCache;
+    static QMutex compiledExprsMutex;
+
+    /* Arena of the trees being compiled: nodes refer to each other by index, it is emptied before each
+       compilation while keeping its capacity, so that building and dropping trees allocates nothing. */
+    QVector<FastTree> nodes;
+
+    QVector<int> nodesIds; // compilation state: id shared by equal subtrees, its uses and its temporary slot
+    QList<int> idsUses, idsTemps;
+
 };
 
 #endif // TREECREATOR_H
@@ -0,0 +1,72 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+#include "Calculus/valuescache.h"
+
+ValuesCache::ValuesCache()
+{
+}
+
+int ValuesCache::slot(double x, double k)
+{
+    uint hash = qHash(x) ^ (31 * qHash(k));
+    return hash & (VALUES_CACHE_SIZE - 1);
+}
+
+bool ValuesCache::find(double x, double k, double &value)
+{
+    if(entries.isEmpty())
+        return false;
+
+    const Entry &entry = entries[slot(x, k)];
+
+    if(entry.used && entry.x == x && entry.k == k)
+    {
+        value = entry.value;
+        return true;
+    }
+    else return false;
+}
+
+void ValuesCache::insert(double x, double k, double value)
+{
+    if(entries.isEmpty()) // entries are only allocated once something is stored
+    {
+        Entry empty;
+        empty.x = empty.k = empty.value = 0;
+        empty.used = false;
+
+        entries.fill(empty, VALUES_CACHE_SIZE);
+    }
+
+    Entry &entry = entries[slot(x, k)];
+    entry.x = x;
+    entry.k = k;
+    entry.value = value;
+    entry.used = true;
+}
+
+void ValuesCache::clear()
+{
+    for(int i = 0 ; i < entries.size() ; i++)
+        entries[i].used = false;
+}
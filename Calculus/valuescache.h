@@ -0,0 +1,55 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+#ifndef VALUESCACHE_H
+#define VALUESCACHE_H
+
+#include "structures.h"
+
+#define VALUES_CACHE_SIZE 4096 // must be a power of two
+
+/* Fixed size, direct mapped memo of values keyed by (x, k): a new entry simply
+   overwrites the one stored in the same slot, so the memory used never grows. */
+
+class ValuesCache
+{
+public:
+    ValuesCache();
+
+    bool find(double x, double k, double &value);
+    void insert(double x, double k, double value);
+    void clear();
+
+protected:
+    struct Entry
+    {
+        double x, k, value;
+        bool used;
+    };
+
+    int slot(double x, double k);
+
+    QVector<Entry> entries;
+};
+
+#endif // VALUESCACHE_H
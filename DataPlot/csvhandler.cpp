@@ -27,7 +27,7 @@ CSVhandler::CSVhandler(QWidget *parent): QDialog(parent), ui(new Ui::CSVconfig)
     ui->setupUi(this);
 
     fileDialog = new QFileDialog(this);
-    fileDialog->setNameFilter(tr("Data (*.csv)"));    
+    fileDialog->setNameFilter(tr("Data (*.csv *.zgd)"));    
 
     job = CSV_NO_FILE;
 
@@ -43,7 +43,7 @@ void CSVhandler::askForFileLocation()
     if(fileDialog->exec())
     {
         ui->fileLocation->setText(fileDialog->selectedFiles().first());
-        if(job == CSV_FILE_SAVE && !ui->fileLocation->text().endsWith(".csv"))
+        if(job == CSV_FILE_SAVE && !ui->fileLocation->text().endsWith(".csv") && !ui->fileLocation->text().endsWith(DATA_FILE_EXTENSION))
             ui->fileLocation->setText(ui->fileLocation->text()+".csv");
 
     }
@@ -60,10 +60,9 @@ void CSVhandler::getDataFromCSV()
     exec();
 }
 
-void CSVhandler::saveCSV(QList<QStringList> data)
+void CSVhandler::saveData(const CSVData &data)
 {
-    values = data;
-    removeUnnecessaryCells();
+    content = data;
 
     setWindowTitle(tr("Save data"));
     ui->apply->setText(tr("Save"));
@@ -72,6 +71,31 @@ void CSVhandler::saveCSV(QList<QStringList> data)
     fileDialog->setAcceptMode(QFileDialog::AcceptSave);
 
     exec();
+
+    content = CSVData(); // also when cancelled: the shared columns would be copied on the table's next edit
+}
+
+void CSVhandler::makeTextValues()
+{
+    values.clear();
+    values << content.names;
+
+    for(int row = 0 ; row < content.rowCount ; row++)
+    {
+        QStringList line;
+
+        for(int col = 0 ; col < content.columns.size() ; col++)
+        {
+            if(std::isnan(content.columns[col][row]))
+                line << QString();
+            else line << QString::number(content.columns[col][row], 'g', MAX_DOUBLE_PREC);
+        }
+
+        values << line;
+    }
+
+    for(const CSVCell &cell : content.expressions)
+        values[cell.row + 1][cell.column] = cell.text;
 }
 
 void CSVhandler::removeUnnecessaryCells()
@@ -129,15 +153,25 @@ void CSVhandler::apply()
         return;
     }
 
-    if(ui->delimiter->text().isEmpty())
+    bool dataFile = ui->fileLocation->text().endsWith(DATA_FILE_EXTENSION);
+
+    if(ui->delimiter->text().isEmpty() && !dataFile)
     {
         QMessageBox::warning(this, tr("Error"), tr("Separator was not specified."));
         return;
     }
 
 
-    if(job == CSV_FILE_SAVE)
+    if(job == CSV_FILE_SAVE && dataFile)
+    {
+        if(!DataFile::save(ui->fileLocation->text(), content))
+            QMessageBox::warning(this, tr("Error"), tr("Unable to write the file."));
+    }
+    else if(job == CSV_FILE_SAVE)
     {
+        makeTextValues();
+        removeUnnecessaryCells();
+
         QFile file(ui->fileLocation->text());
         if(file.open(QFile::WriteOnly | QFile::Truncate | QFile::Text))
         {
@@ -147,22 +181,24 @@ void CSVhandler::apply()
 
             file.close();
         }
+
+        values.clear();
     }
     else if(job == CSV_FILE_OPEN)
     {
-        QFile file(ui->fileLocation->text());
-        values.clear();
+        CSVData data;
+        bool ok;
 
-        if(file.open(QFile::ReadOnly | QFile::Text))
-        {
-            QTextStream in(&file);
-            while(!in.atEnd())
-                values << in.readLine().split(ui->delimiter->text());
+        if(dataFile)
+            ok = DataFile::load(ui->fileLocation->text(), data);
+        else ok = CSVParser::parseFile(ui->fileLocation->text(), ui->delimiter->text(), data);
 
-            file.close();
-            emit dataFromCSV(values);
-        }
+        if(ok)
+            emit dataFromCSV(data);
+        else QMessageBox::warning(this, tr("Error"), tr("Unable to read the file."));
     }
 
+    content = CSVData();
+
     close();
 }
@@ -26,6 +26,9 @@
 #include <QtWidgets>
 
 #include "ui_csvconfig.h"
+#include "structures.h"
+#include "DataPlot/csvparser.h"
+#include "DataPlot/datafile.h"
 
 
 enum Job {CSV_FILE_SAVE, CSV_FILE_OPEN, CSV_NO_FILE};
@@ -39,20 +42,22 @@ public:
     CSVhandler(QWidget *parent);
 
     void getDataFromCSV();
-    void saveCSV(QList<QStringList> data);
+    void saveData(const CSVData &data);
 
 signals:
-    void dataFromCSV(QList<QStringList>);
+    void dataFromCSV(const CSVData &data);
 
 protected slots:
     void askForFileLocation();
     void apply();
 
 protected:
+    void makeTextValues();
     void removeUnnecessaryCells();
 
     Ui::CSVconfig *ui;
     Job job;
+    CSVData content;
     QList<QStringList> values;
     QFileDialog *fileDialog;
 
@@ -0,0 +1,258 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#include "DataPlot/csvparser.h"
+#include <QtConcurrent>
+#include <clocale>
+
+struct CSVChunk
+{
+    const char *begin, *end;
+    CSVData data;
+};
+
+bool CSVParser::parseFile(const QString &fileName, const QString &delimiter, CSVData &data)
+{
+    QFile file(fileName);
+
+    if(!file.open(QFile::ReadOnly))
+        return false;
+
+    QByteArray content;
+    const char *begin = NULL;
+
+    if(file.size() > 0)
+        begin = (const char*)file.map(0, file.size());
+
+    if(begin == NULL) // mapping isn't supported everywhere
+    {
+        content = file.readAll();
+        begin = content.constData();
+    }
+
+    parse(begin, begin + (content.isNull() ? file.size() : content.size()), delimiter.toUtf8(), data);
+
+    file.close();
+
+    return true;
+}
+
+void CSVParser::parse(const char *begin, const char *end, const QByteArray &delimiter, CSVData &data)
+{
+    data.names.clear();
+    data.columns.clear();
+    data.expressions.clear();
+    data.rowCount = 0;
+
+    if(begin == end || delimiter.isEmpty())
+        return;
+
+    const char *bodyStart = nextLine(begin, end);
+
+    for(const QByteArray &name : splitLine(begin, bodyStart, delimiter))
+        data.names << QString::fromUtf8(name);
+
+    QVector<CSVChunk> chunks;
+    int chunksCount = qMax(1, QThread::idealThreadCount() * CSV_CHUNKS_PER_THREAD);
+    qint64 chunkSize = (end - bodyStart) / chunksCount + 1;
+
+    for(const char *pos = bodyStart ; pos < end ; )
+    {
+        CSVChunk chunk;
+        chunk.begin = pos;
+        chunk.end = pos + chunkSize < end ? nextLine(pos + chunkSize, end) : end;
+        chunks << chunk;
+
+        pos = chunk.end;
+    }
+
+    char decimalPoint = localeconv()->decimal_point[0]; // strtod() follows LC_NUMERIC, localeconv() isn't thread safe
+
+    QtConcurrent::blockingMap(chunks, [&delimiter, decimalPoint](CSVChunk &chunk) { parseChunk(chunk.begin, chunk.end, delimiter, decimalPoint, chunk.data); });
+
+    int columnCount = 0;
+
+    for(const CSVChunk &chunk : chunks)
+    {
+        data.rowCount += chunk.data.rowCount;
+        columnCount = qMax(columnCount, chunk.data.columns.size());
+    }
+
+    for(int column = 0 ; column < columnCount ; column++)
+    {
+        data.columns << QVector<double>();
+        data.columns[column].reserve(data.rowCount);
+    }
+
+    int firstRow = 0;
+
+    for(const CSVChunk &chunk : chunks)
+    {
+        for(int column = 0 ; column < columnCount ; column++)
+        {
+            if(column < chunk.data.columns.size())
+                data.columns[column] += chunk.data.columns[column];
+            else data.columns[column].insert(data.columns[column].size(), chunk.data.rowCount, NAN);
+        }
+
+        for(CSVCell cell : chunk.data.expressions)
+        {
+            cell.row += firstRow;
+            data.expressions << cell;
+        }
+
+        firstRow += chunk.data.rowCount;
+    }
+}
+
+bool CSVParser::readNumber(const char *begin, const char *end, char decimalPoint, double &value)
+{
+    // copied to a buffer on the stack: strtod() needs a terminated string, and no cell should cost an allocation
+
+    char buffer[CSV_NUMBER_MAX_LENGTH + 1];
+    int length = end - begin;
+
+    if(length > CSV_NUMBER_MAX_LENGTH)
+        return false;
+
+    for(int i = 0 ; i < length ; i++)
+    {
+        char c = begin[i];
+
+        // strtod() would also read hexadecimal numbers, and words such as "infinity"
+        if(!isdigit(uchar(c)) && strchr("+-.eEiInNaAfF", c) == NULL)
+            return false;
+
+        buffer[i] = c == '.' ? decimalPoint : c;
+    }
+
+    buffer[length] = '\0';
+
+    char *numberEnd = NULL;
+    value = strtod(buffer, &numberEnd);
+
+    return numberEnd == buffer + length;
+}
+
+void CSVParser::parseChunk(const char *begin, const char *end, const QByteArray &delimiter, char decimalPoint, CSVData &chunk)
+{
+    chunk.rowCount = 0;
+
+    for(const char *line = begin ; line < end ; line = nextLine(line, end))
+    {
+        const char *lineEnd = nextLine(line, end);
+        const char *field = line;
+        int column = 0;
+
+        if(lineEnd > line && lineEnd[-1] == '\n')
+            lineEnd--;
+        if(lineEnd > line && lineEnd[-1] == '\r')
+            lineEnd--;
+
+        forever
+        {
+            const char *fieldEnd = findDelimiter(field, lineEnd, delimiter);
+
+            if(column == chunk.columns.size())
+                chunk.columns << QVector<double>(chunk.rowCount, NAN);
+
+            const char *first = field, *last = fieldEnd;
+
+            while(first < last && isspace(uchar(*first)))
+                first++;
+            while(last > first && isspace(uchar(last[-1])))
+                last--;
+
+            double value = NAN;
+
+            if(first != last && !readNumber(first, last, decimalPoint, value))
+            {
+                CSVCell cell;
+                cell.row = chunk.rowCount;
+                cell.column = column;
+                cell.text = QString::fromUtf8(field, fieldEnd - field);
+                chunk.expressions << cell;
+
+                value = NAN;
+            }
+
+            chunk.columns[column] << value;
+            column++;
+
+            if(fieldEnd == lineEnd)
+                break;
+
+            field = fieldEnd + delimiter.size();
+        }
+
+        chunk.rowCount++;
+
+        for( ; column < chunk.columns.size() ; column++)
+            chunk.columns[column] << NAN;
+    }
+}
+
+const char* CSVParser::nextLine(const char *pos, const char *end)
+{
+    const char *newLine = (const char*)memchr(pos, '\n', end - pos);
+    return newLine == NULL ? end : newLine + 1;
+}
+
+const char* CSVParser::findDelimiter(const char *pos, const char *end, const QByteArray &delimiter)
+{
+    while(pos < end)
+    {
+        pos = (const char*)memchr(pos, delimiter[0], end - pos);
+
+        if(pos == NULL || end - pos < delimiter.size())
+            return end;
+        if(memcmp(pos, delimiter.constData(), delimiter.size()) == 0)
+            return pos;
+
+        pos++;
+    }
+
+    return end;
+}
+
+QList<QByteArray> CSVParser::splitLine(const char *pos, const char *end, const QByteArray &delimiter)
+{
+    QList<QByteArray> fields;
+
+    if(end > pos && end[-1] == '\n')
+        end--;
+    if(end > pos && end[-1] == '\r')
+        end--;
+
+    forever
+    {
+        const char *fieldEnd = findDelimiter(pos, end, delimiter);
+        fields << QByteArray(pos, fieldEnd - pos);
+
+        if(fieldEnd == end)
+            return fields;
+
+        pos = fieldEnd + delimiter.size();
+    }
+}
@@ -0,0 +1,64 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#ifndef CSVPARSER_H
+#define CSVPARSER_H
+
+#include <QtWidgets>
+
+#define CSV_CHUNKS_PER_THREAD 4 // the file is split in that many chunks per thread, at line boundaries
+#define CSV_NUMBER_MAX_LENGTH 64 // longer fields aren't plain numbers, they are left to the expressions
+
+struct CSVCell
+{
+    int row, column;
+    QString text;
+};
+
+struct CSVData // content of a CSV file: the first line names the columns, the next ones are the rows
+{
+    QStringList names;
+    QList< QVector<double> > columns; // columns[column][row], NAN for empty cells
+    QList<CSVCell> expressions; // cells that aren't plain numbers, left for the data table to evaluate
+    int rowCount;
+};
+
+/* Reads a CSV file memory mapped, without going through strings: chunks of lines are parsed by a
+   thread pool, each filling its own numeric columns, which are then concatenated. */
+
+class CSVParser
+{
+public:
+    static bool parseFile(const QString &fileName, const QString &delimiter, CSVData &data);
+    static void parse(const char *begin, const char *end, const QByteArray &delimiter, CSVData &data);
+
+protected:
+    static const char* nextLine(const char *pos, const char *end);
+    static const char* findDelimiter(const char *pos, const char *end, const QByteArray &delimiter);
+    static QList<QByteArray> splitLine(const char *pos, const char *end, const QByteArray &delimiter);
+    static bool readNumber(const char *begin, const char *end, char decimalPoint, double &value);
+    static void parseChunk(const char *begin, const char *end, const QByteArray &delimiter, char decimalPoint, CSVData &chunk);
+};
+
+#endif // CSVPARSER_H
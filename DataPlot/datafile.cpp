@@ -0,0 +1,321 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#include "DataPlot/datafile.h"
+#include <QtConcurrent>
+#include <QtEndian>
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+static void swapBytes(double *values, int count)
+{
+    quint64 bits;
+
+    for(int i = 0 ; i < count ; i++)
+    {
+        memcpy(&bits, values + i, sizeof(double));
+        bits = qbswap(bits);
+        memcpy(values + i, &bits, sizeof(double));
+    }
+}
+#endif
+
+struct DataFileBlock
+{
+    const char *source;
+    DataFileChunk chunk;
+    double *target;
+};
+
+bool DataFile::save(const QString &fileName, const CSVData &data)
+{
+    QFile file(fileName);
+
+    if(!file.open(QFile::WriteOnly | QFile::Truncate))
+        return false;
+
+    int columnCount = data.columns.size();
+    int chunksCount = (data.rowCount + DATA_FILE_CHUNK_ROWS - 1) / DATA_FILE_CHUNK_ROWS;
+
+    // blocks are prepared first, their offsets must be known to write the header
+
+    QList< QVector<QByteArray> > blocks;
+    QList< QVector<DataFileChunk> > chunks;
+
+    for(int column = 0 ; column < columnCount ; column++)
+    {
+        blocks << QVector<QByteArray>(chunksCount);
+        chunks << QVector<DataFileChunk>(chunksCount);
+    }
+
+    QVector<QPoint> blocksIds; // x: column, y: chunk
+
+    for(int column = 0 ; column < columnCount ; column++)
+        for(int chunk = 0 ; chunk < chunksCount ; chunk++)
+            blocksIds << QPoint(column, chunk);
+
+    QtConcurrent::blockingMap(blocksIds, [&](const QPoint &id) {
+        int first = id.y() * DATA_FILE_CHUNK_ROWS;
+        int count = qMin(DATA_FILE_CHUNK_ROWS, data.rowCount - first);
+        QByteArray block = QByteArray::fromRawData((const char*)(data.columns[id.x()].constData() + first), count * sizeof(double));
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+        block.detach();
+        swapBytes((double*)block.data(), count);
+#endif
+        QByteArray compressed = qCompress(block, 1);
+
+        chunks[id.x()][id.y()].rawSize = block.size();
+
+        if(compressed.size() < DATA_FILE_COMPRESSION_GAIN * block.size())
+            blocks[id.x()][id.y()] = compressed;
+        else blocks[id.x()][id.y()] = block;
+
+        chunks[id.x()][id.y()].storedSize = blocks[id.x()][id.y()].size();
+    });
+
+    QByteArray header;
+    QDataStream out(&header, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    out.writeRawData(DATA_FILE_MAGIC, 8);
+    out << quint32(DATA_FILE_VERSION) << quint32(columnCount) << quint64(data.rowCount) << quint32(DATA_FILE_CHUNK_ROWS);
+
+    for(int column = 0 ; column < columnCount ; column++)
+    {
+        QByteArray name = data.names.value(column).toUtf8();
+        out << quint32(DATA_COLUMN_DOUBLE) << quint32(name.size());
+        out.writeRawData(name.constData(), name.size());
+    }
+
+    int chunksTablePos = header.size();
+
+    for(int i = 0 ; i < columnCount * chunksCount ; i++)
+        out << quint64(0) << quint32(0) << quint32(0); // filled once the header size is known
+
+    out << quint32(data.expressions.size());
+
+    for(const CSVCell &cell : data.expressions)
+    {
+        QByteArray text = cell.text.toUtf8();
+        out << quint64(cell.row) << quint32(cell.column) << quint32(text.size());
+        out.writeRawData(text.constData(), text.size());
+    }
+
+    while(header.size() % sizeof(double) != 0)
+        out << quint8(0);
+
+    quint64 offset = header.size();
+
+    out.device()->seek(chunksTablePos);
+
+    for(int column = 0 ; column < columnCount ; column++)
+    {
+        for(int chunk = 0 ; chunk < chunksCount ; chunk++)
+        {
+            chunks[column][chunk].offset = offset;
+            offset += chunks[column][chunk].storedSize;
+
+            out << chunks[column][chunk].offset << chunks[column][chunk].storedSize << chunks[column][chunk].rawSize;
+        }
+    }
+
+    bool ok = file.write(header) == header.size();
+
+    for(int column = 0 ; column < columnCount && ok ; column++)
+        for(int chunk = 0 ; chunk < chunksCount && ok ; chunk++)
+            ok = file.write(blocks[column][chunk]) == blocks[column][chunk].size();
+
+    file.close();
+
+    return ok;
+}
+
+bool DataFile::load(const QString &fileName, CSVData &data)
+{
+    QFile file(fileName);
+
+    if(!file.open(QFile::ReadOnly))
+        return false;
+
+    qint64 size = file.size();
+    QScopedArrayPointer<char> content; // a QByteArray from readAll() couldn't hold files of 2 GiB or more
+    const char *begin = NULL;
+
+    if(size > 0)
+        begin = (const char*)file.map(0, size);
+
+    if(begin == NULL && size > 0) // mapping isn't supported everywhere
+    {
+        content.reset(new char[size]);
+
+        if(file.read(content.data(), size) != size)
+            return false;
+
+        begin = content.data();
+    }
+
+    bool ok = readContent(begin, size, data);
+
+    file.close();
+
+    return ok;
+}
+
+bool DataFile::readContent(const char *begin, qint64 size, CSVData &data)
+{
+    data.names.clear();
+    data.columns.clear();
+    data.expressions.clear();
+    data.rowCount = 0;
+
+    if(size < 8 || memcmp(begin, DATA_FILE_MAGIC, 8) != 0)
+        return false;
+
+    // only the header is read through the stream, the bounds are checked against the 64 bits size
+    QDataStream in(QByteArray::fromRawData(begin, int(qMin(size, qint64(INT_MAX)))));
+    in.setByteOrder(QDataStream::LittleEndian);
+    in.skipRawData(8);
+
+    quint32 version, columnCount, chunkRows, type, nameSize, storedSize, rawSize, cellsCount, column, textSize;
+    quint64 rowCount, offset, row;
+
+    in >> version >> columnCount >> rowCount >> chunkRows;
+
+    /* Nothing is allocated from the header's counts before they are checked against the bytes left in the file:
+       every column takes at least 8 bytes of header, every block 16 bytes of table, and the values can't inflate
+       to more than 1024 times the file's size, nor to another size than their block's. Divisions keep crafted
+       counts from overflowing the checks. */
+
+    quint64 remaining = quint64(size - in.device()->pos());
+
+    if(in.status() != QDataStream::Ok || version > DATA_FILE_VERSION || chunkRows == 0 || rowCount > quint64(INT_MAX)
+            || columnCount > remaining / 8 || (columnCount != 0 && rowCount > quint64(size) * 1024 / sizeof(double) / columnCount))
+        return false;
+
+    quint64 chunksCount = (rowCount + chunkRows - 1) / chunkRows;
+
+    if(columnCount != 0 && chunksCount > remaining / 16 / columnCount)
+        return false;
+
+    for(quint32 i = 0 ; i < columnCount ; i++)
+    {
+        in >> type >> nameSize;
+
+        if(in.status() != QDataStream::Ok || type != DATA_COLUMN_DOUBLE || nameSize > quint64(size - in.device()->pos()))
+            return false;
+
+        QByteArray name(nameSize, 0);
+
+        if(in.readRawData(name.data(), nameSize) != int(nameSize))
+            return false;
+        data.names << QString::fromUtf8(name);
+    }
+
+    QVector<DataFileBlock> blocks; // column after column, the targets are set once the columns are allocated
+
+    for(quint32 i = 0 ; i < columnCount ; i++)
+    {
+        for(quint64 chunk = 0 ; chunk < chunksCount ; chunk++)
+        {
+            in >> offset >> storedSize >> rawSize;
+
+            quint64 rows = qMin(quint64(chunkRows), rowCount - chunk * chunkRows);
+
+            if(in.status() != QDataStream::Ok || offset > quint64(size) || storedSize > quint64(size) - offset || rawSize != rows * sizeof(double))
+                return false;
+
+            // qUncompress() allocates the size its block starts with, big endian, before inflating anything
+            if(storedSize != rawSize && (storedSize < 4 || qFromBigEndian<quint32>((const uchar*)begin + offset) != rawSize))
+                return false;
+
+            DataFileBlock block;
+            block.source = begin + offset;
+            block.chunk.offset = offset;
+            block.chunk.storedSize = storedSize;
+            block.chunk.rawSize = rawSize;
+            block.target = NULL;
+            blocks << block;
+        }
+    }
+
+    in >> cellsCount;
+
+    for(quint32 i = 0 ; i < cellsCount ; i++)
+    {
+        in >> row >> column >> textSize;
+
+        if(in.status() != QDataStream::Ok || row >= rowCount || column >= columnCount || textSize > quint64(size - in.device()->pos()))
+            return false;
+
+        QByteArray text(textSize, 0);
+
+        if(in.readRawData(text.data(), textSize) != int(textSize))
+            return false;
+
+        CSVCell cell;
+        cell.row = row;
+        cell.column = column;
+        cell.text = QString::fromUtf8(text);
+        data.expressions << cell;
+    }
+
+    if(in.status() != QDataStream::Ok)
+        return false;
+
+    for(quint32 i = 0 ; i < columnCount ; i++)
+        data.columns << QVector<double>(rowCount);
+
+    for(int i = 0 ; i < blocks.size() ; i++)
+        blocks[i].target = data.columns[i / chunksCount].data() + (i % chunksCount) * chunkRows;
+
+    QAtomicInt errors(0);
+
+    QtConcurrent::blockingMap(blocks, [&errors](const DataFileBlock &block) {
+        if(block.chunk.storedSize == block.chunk.rawSize)
+            memcpy(block.target, block.source, block.chunk.rawSize);
+        else
+        {
+            QByteArray raw = qUncompress((const uchar*)block.source, block.chunk.storedSize);
+
+            if(quint32(raw.size()) != block.chunk.rawSize)
+            {
+                errors.ref();
+                return;
+            }
+
+            memcpy(block.target, raw.constData(), block.chunk.rawSize);
+        }
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+        swapBytes(block.target, block.chunk.rawSize / sizeof(double));
+#endif
+    });
+
+    if(errors.load() != 0)
+        return false;
+
+    data.rowCount = rowCount;
+
+    return true;
+}
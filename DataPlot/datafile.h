@@ -0,0 +1,63 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#ifndef DATAFILE_H
+#define DATAFILE_H
+
+#include "DataPlot/csvparser.h"
+
+#define DATA_FILE_EXTENSION ".zgd"
+#define DATA_FILE_MAGIC "ZGDATA\r\n"
+#define DATA_FILE_VERSION 1
+#define DATA_FILE_CHUNK_ROWS 65536 // rows per block of a column, blocks are compressed and read independently
+#define DATA_FILE_COMPRESSION_GAIN 0.75 // a block is stored compressed only if it shrinks below this ratio
+
+enum DataColumnType {DATA_COLUMN_DOUBLE};
+
+struct DataFileChunk
+{
+    quint64 offset;
+    quint32 storedSize, rawSize; // rawSize != storedSize for compressed blocks
+};
+
+/* Native data file (.zgd), little endian:
+     - magic, version, column count, row count, rows per block
+     - per column: type and UTF-8 name
+     - per column and per block: offset in the file, stored size, raw size
+     - text of the cells that aren't numbers: row, column, UTF-8 text
+     - blocks of doubles, each column's values following each other
+   Opening maps the file: raw blocks are copied straight into the columns, without any parsing,
+   compressed ones are inflated in parallel. */
+
+class DataFile
+{
+public:
+    static bool save(const QString &fileName, const CSVData &data);
+    static bool load(const QString &fileName, CSVData &data);
+
+protected:
+    static bool readContent(const char *begin, qint64 size, CSVData &data);
+};
+
+#endif // DATAFILE_H
@@ -21,8 +21,7 @@
 
 
 #include "DataPlot/datatable.h"
-
-int refCol;
+#include <QtConcurrent>
 
 DataTable::DataTable(Information *info, int rowCount, int columnCount, int rowHeight, int columnWidth)
 {
@@ -33,52 +32,40 @@ DataTable::DataTable(Information *info, int rowCount, int columnCount, int rowHe
     calculator = new ExprCalculator(false, information->getFuncsList());
     treeCreator = new TreeCreator(DATA_TABLE_EXPR);
 
-    tableWidget = new QTableWidget(rowCount,columnCount);
+    model = new DataTableModel(calculator, rowCount, columnCount, this);
+
+    tableView = new QTableView;
+    tableView->setModel(model);
 
-    tableWidget->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    tableWidget->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    // the view scrolls vertically by itself: laid out at full height, it couldn't go past the widget height limit
+    tableView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    tableView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    tableView->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
 
-    tableWidget->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
-    tableWidget->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    tableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
 
-    tableWidget->horizontalHeader()->setSectionsMovable(true);
+    tableView->horizontalHeader()->setSectionsMovable(true);
 
-    tableWidget->horizontalHeader()->setFixedHeight(25);
+    tableView->horizontalHeader()->setFixedHeight(25);
 
     resizeColumns(columnWidth);
     resizeRows(rowHeight);
 
-    disableChecking = true;
-
-    for(int col = 0 ; col < columnCount ; col++)
-    {
-        values << QList<double>();
-        for(int row = 0 ; row < rowCount ; row++)
-        {
-            QTableWidgetItem *item = new QTableWidgetItem(" ");
-            tableWidget->setItem(row, col, item);
-            values[col] << NAN ;
-        }
-    }
-
-    backgroundColor = palette().base().color();
-    textColor = palette().text().color();
-
-    disableChecking = false;
-
-    connect(tableWidget, SIGNAL(itemChanged(QTableWidgetItem*)), this, SLOT(checkCell(QTableWidgetItem*)));
+    connect(model, SIGNAL(cellEdited(int,int)), this, SLOT(checkCell(int,int)));
 
-    connect(tableWidget->horizontalHeader(), SIGNAL(sectionDoubleClicked(int)), this, SLOT(renameColumn(int)));
-    connect(tableWidget->horizontalHeader(), SIGNAL(sectionMoved(int,int,int)), this, SIGNAL(columnMoved(int, int, int)));
+    connect(tableView->horizontalHeader(), SIGNAL(sectionDoubleClicked(int)), this, SLOT(renameColumn(int)));
+    connect(tableView->horizontalHeader(), SIGNAL(sectionMoved(int,int,int)), this, SIGNAL(columnMoved(int, int, int)));
+    connect(tableView->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SIGNAL(verticalScrollOffsetChanged(int)));
 
-    mainLayout->addWidget(tableWidget);
+    mainLayout->addWidget(tableView);
     mainLayout->addStretch();
     setLayout(mainLayout);
 
     for(int i = 0 ; i < columnCount ; i++) { columnNames << tr("Rename me!") ; }
-    tableWidget->setHorizontalHeaderLabels(columnNames);
+    model->setColumnNames(columnNames);
 
-    tableWidget->installEventFilter(this);
+    tableView->installEventFilter(this);
 
     nameValidator.setPattern("^([a-z]|[A-Z])+(_([a-z]|[A-Z])+)*$");
 
@@ -86,9 +73,10 @@ DataTable::DataTable(Information *info, int rowCount, int columnCount, int rowHe
 
 void DataTable::checkVerticalHeaderNewWidth()
 {
-    if(verticalHeaderWidth != tableWidget->verticalHeader()->width())
+    if(verticalHeaderWidth != tableView->verticalHeader()->width())
     {
-        verticalHeaderWidth = tableWidget->verticalHeader()->width();
+        verticalHeaderWidth = tableView->verticalHeader()->width();
+        updateWidth();
         emit newPosCorrections();
     }
 }
@@ -101,18 +89,29 @@ bool DataTable::eventFilter(QObject *obj, QEvent *event)
     {
         QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
 
-        if(keyEvent->key() == Qt::Key_Return && tableWidget->currentItem() != nullptr)
+        if(keyEvent->key() == Qt::Key_Return && tableView->currentIndex().isValid())
         {
-            QTableWidgetItem *item = tableWidget->currentItem();
-            tableWidget->setCurrentItem(tableWidget->item(item->row()+1,item->column()));
+            QModelIndex index = tableView->currentIndex();
+            tableView->setCurrentIndex(model->index(index.row()+1, index.column()));
             return true;
         }
-        else if( (keyEvent->key() == Qt::Key_Delete || keyEvent->key() == Qt::Key_Backspace) && !tableWidget->selectedItems().empty())
+        else if( (keyEvent->key() == Qt::Key_Delete || keyEvent->key() == Qt::Key_Backspace) && tableView->selectionModel()->hasSelection())
         {
-            for(auto &item : tableWidget->selectedItems())
+            QList<int> editedColumns;
+
+            for(auto &index : tableView->selectionModel()->selectedIndexes())
             {
-                item->setText("");
+                model->setValue(index.row(), index.column(), NAN);
+                if(!editedColumns.contains(index.column()))
+                    editedColumns << index.column();
             }
+
+            for(int col : editedColumns)
+            {
+                model->valuesChanged(col, col);
+                emit valEdited(0, colVisualIndex(col));
+            }
+
             removeUnnecessaryRows();
             removeUnnecessaryColumns();
 
@@ -126,398 +125,296 @@ bool DataTable::eventFilter(QObject *obj, QEvent *event)
 
 QString DataTable::getColumnName(int visualIndex)
 {
-    return tableWidget->horizontalHeaderItem(tableWidget->horizontalHeader()->logicalIndex(visualIndex))->text();
+    return columnNames[colLogicalIndex(visualIndex)];
 }
 
-int doubleCompareAscend(double a, double b)
+CSVData DataTable::getContent()
 {
-    if(std::isnan(b))
-        return -1;
-    else return a<b;
-}
+    //columns in visual order, the arrays are implicitly shared with the model's
 
-int doubleCompareDescend(double a, double b)
-{
-    if(std::isnan(b))
-        return 1;
-    else return a>b;
-}
+    CSVData content;
+    content.rowCount = model->rowCount();
 
-QList<QStringList> DataTable::getData()
-{
-    QList<QStringList> data;
+    for(int i = 0 ; i < model->columnCount() ; i++)
+    {
+        int col = colLogicalIndex(i);
 
-    QStringList columnNamesVisualOrder;
-    for(int i = 0 ; i < tableWidget->horizontalHeader()->count() ; i++)
-        columnNamesVisualOrder << tableWidget->horizontalHeaderItem(tableWidget->horizontalHeader()->logicalIndex(i))->text();
+        content.names << columnNames[col];
+        content.columns << model->getValues()[col];
 
-    data << columnNamesVisualOrder;
+        const QHash<int, QString> &invalidCells = model->getInvalidCells(col);
 
-    for(int i = 0 ; i < tableWidget->rowCount(); i++)
-    {
-        data << QStringList();
-        for(int j = 0 ; j < tableWidget->columnCount(); j++)
-            data[i+1] << tableWidget->item(i,tableWidget->horizontalHeader()->logicalIndex(j))->text();
+        for(auto it = invalidCells.constBegin() ; it != invalidCells.constEnd() ; it++)
+        {
+            CSVCell cell;
+            cell.row = it.key();
+            cell.column = i;
+            cell.text = it.value();
+            content.expressions << cell;
+        }
     }
 
-    return data;
+    return content;
 }
 
 void DataTable::removeUnnecessaryColumns()
 {
-    //removing unnecessary columns but not the last one
-
-    bool unnecessary = false;
+    //removing unnecessary columns but not the last one, each run of them in a single removal
 
-    int col = 0;
+    QList<QPair<int, int> > runs = unnecessaryRuns(model->columnCount() - 1, model->columnCount() - MIN_COLUMN_COUNT, false);
 
-    while(col < tableWidget->columnCount()-1 && tableWidget->columnCount() > MIN_COLUMN_COUNT)
+    for(int i = runs.size() - 1 ; i >= 0 ; i--)
     {
-        if(columnNames[col] != tr("Rename me!"))
-        {
-            col++;
-            continue;
-        }
+        model->removeColumns(runs[i].first, runs[i].second);
+
+        for(int n = 0 ; n < runs[i].second ; n++)
+            columnNames.removeAt(runs[i].first);
+    }
 
-        unnecessary = true;
+    if(runs.isEmpty())
+        return;
 
-        for(int row = 0 ; row < tableWidget->rowCount() && unnecessary; row++)
-            unnecessary = tableWidget->item(row, col)->text().isEmpty() || tableWidget->item(row, col)->text() == " ";
+    model->setColumnNames(columnNames);
 
-        if(unnecessary && tableWidget->columnCount() > MIN_COLUMN_COUNT)
-            removeColumn(col);
-        else col++;
-    }
+    updateWidth();
+
+    emit newColumnCount(model->columnCount());
 }
 
 void DataTable::removeUnnecessaryRows()
 {
-    //removing rows, but not the last one
+    //removing rows, but not the last one, each run of them in a single removal
 
-    int row = 0;
-    bool unnecessary = false;
+    int oldCount = model->rowCount();
+    QList<QPair<int, int> > runs = unnecessaryRuns(oldCount - 1, oldCount - MIN_ROW_COUNT, true);
 
-    while(row < tableWidget->rowCount()-1 && tableWidget->rowCount() > MIN_ROW_COUNT)
-    {
-        unnecessary = true;
+    for(int i = runs.size() - 1 ; i >= 0 ; i--)
+        model->removeRows(runs[i].first, runs[i].second);
 
-        for(int col = 0 ; col < tableWidget->columnCount() && unnecessary; col++)
-            unnecessary = tableWidget->item(row, col)->text().isEmpty() || tableWidget->item(row, col)->text() == " ";
+    if(runs.isEmpty())
+        return;
 
-        if(unnecessary && tableWidget->rowCount() > MIN_ROW_COUNT)
-            removeRow(row);
-        else row++;
-    }
+    rowCountChanged(oldCount);
 }
 
-void DataTable::addData(QList<QStringList> data)
+QList<QPair<int, int> > DataTable::unnecessaryRuns(int count, int removable, bool rows)
 {
-    //the first line of the CSV file must contain column names, matching the validator, or left blank
+    //runs of empty rows (or unnamed empty columns) among the first "count" ones, as (start, length),
+    //the first ones found being kept within the "removable" budget
 
-    int indexOfLastInsertedColumn = 0;    
+    QList<QPair<int, int> > runs;
 
-    if(!data.isEmpty())
+    for(int i = 0 ; i < count && removable > 0 ; i++)
     {
-        for(int column = 0 ; column < data[0].size(); column++)
-        {
-            if(column == indexOfLastInsertedColumn)
-            {
-                insertColumn(column);
-                indexOfLastInsertedColumn++;
-            }
+        bool unnecessary = rows || columnNames[i] == tr("Rename me!");
 
-            if(nameValidator.exactMatch(data[0][column]))
-                columnNames[column] = data[0][column];
-        }
-    }
+        if(rows)
+            for(int col = 0 ; col < model->columnCount() && unnecessary ; col++)
+                unnecessary = model->isCellEmpty(i, col);
+        else
+            for(int row = 0 ; row < model->rowCount() && unnecessary ; row++)
+                unnecessary = model->isCellEmpty(row, i);
 
-    tableWidget->setHorizontalHeaderLabels(columnNames);
+        if(!unnecessary)
+            continue;
 
-    for(int row = 1 ; row < data.size(); row++)
-    {
-        if(tableWidget->rowCount() == row)
-            addRow();
+        if(!runs.isEmpty() && runs.last().first + runs.last().second == i)
+            runs.last().second++;
+        else runs << qMakePair(i, 1);
 
-        for(int column = 0 ; column < data[row].size(); column++)
-        {
-            if(column == indexOfLastInsertedColumn)
-            {
-                insertColumn(column);
-                indexOfLastInsertedColumn++;
-            }
-
-            tableWidget->item(row-1, column)->setText(data[row][column]);
-        }
+        removable--;
     }
 
-    removeUnnecessaryRows();
-    removeUnnecessaryColumns();
+    return runs;
 }
 
-void DataTable::sortColumnSwapCells(int col, bool ascending)
+void DataTable::addData(const CSVData &data)
 {
-    col = tableWidget->horizontalHeader()->logicalIndex(col);
+    //the first line of the CSV file must contain column names, matching the validator, or left blank
+    //the file's columns are inserted first, its numbers go straight to the model, only the other cells are evaluated
+
+    int columnCount = qMax(data.names.size(), data.columns.size());
 
-    if(ascending)
-        qSort(values[col].begin(), values[col].end(), doubleCompareAscend);
-    else qSort(values[col].begin(), values[col].end(), doubleCompareDescend);
+    for(int column = 0 ; column < columnCount ; column++)
+    {
+        insertColumn(column);
 
-    disableChecking = true;
+        if(column < data.names.size() && nameValidator.exactMatch(data.names[column]))
+            columnNames[column] = data.names[column];
+    }
 
-    for(int row = 0 ; row < tableWidget->rowCount(); row++)
+    model->setColumnNames(columnNames);
+
+    if(data.rowCount >= model->rowCount()) // one empty row is kept at the end
+        addRows(data.rowCount + 1 - model->rowCount());
+
+    QList< QVector<double> > &values = model->getValues();
+
+    for(int column = 0 ; column < data.columns.size() ; column++)
+        std::copy(data.columns[column].constBegin(), data.columns[column].constEnd(), values[column].begin());
+
+    for(const CSVCell &cell : data.expressions)
     {
-        if(std::isnan(values[col][row]))
-        {
-            tableWidget->item(row,col)->setText("");
-            tableWidget->item(row,col)->setBackgroundColor(backgroundColor);
-            tableWidget->item(row,col)->setTextColor(textColor);
-        }
-        else
-        {
-            tableWidget->item(row,col)->setText(QString::number(values[col][row], 'g', MAX_DOUBLE_PREC));
-            tableWidget->item(row,col)->setBackgroundColor(VALID_COLOR);
-            tableWidget->item(row,col)->setTextColor(Qt::black);
-        }
+        bool ok = false;
+        double val = calculator->calculateExpression(cell.text, ok);
+
+        if(ok)
+            model->setValue(cell.row, cell.column, val);
+        else model->setInvalidCell(cell.row, cell.column, cell.text);
     }
 
-    disableChecking = false;
+    if(columnCount > 0)
+        model->valuesChanged(0, columnCount - 1);
 
-    emit valEdited(0, col);
+    removeUnnecessaryRows();
+    removeUnnecessaryColumns();
 }
 
-int listCompareAscend(QList<double> a, QList<double>b)
+void DataTable::sortColumnSwapCells(int col, bool ascending)
 {
-    if(std::isnan(b[refCol]))
-        return -1;
-    else return a[refCol] < b[refCol];
-}
+    col = colLogicalIndex(col);
 
-int listCompareDescend(QList<double> a, QList<double>b)
-{
-    if(std::isnan(b[refCol]))
-        return 1;
-    else return a[refCol] > b[refCol];
+    model->reorderColumn(col, model->sortedRows(col, ascending));
+
+    emit valEdited(0, colVisualIndex(col));
 }
 
 void DataTable::sortColumnSwapRows(int column, bool ascending)
 {
-    column = tableWidget->horizontalHeader()->logicalIndex(column);
+    column = colLogicalIndex(column);
 
-    QList<QList<double> > vals; //this time it will be vals[row][column] just to apply qSort on it, since QSorting values can be made only on columns...
+    model->reorderRows(model->sortedRows(column, ascending));
 
-    for(int row = 0 ; row < tableWidget->rowCount(); row++)
-    {
-        vals << QList<double>();
-        for(int col = 0 ; col < tableWidget->columnCount(); col++)
-            vals[row] << values[col][row];
-    }
-
-    refCol = column;
-    if(ascending)
-        qSort(vals.begin(), vals.end(), listCompareAscend);
-    else qSort(vals.begin(), vals.end(), listCompareDescend);
-
-    disableChecking = true;
-
-    for(int row = 0 ; row < tableWidget->rowCount(); row++)
-    {
-        for(int col = 0 ; col < tableWidget->columnCount(); col++)
-        {
-            values[col][row] = vals[row][col];
-            if(std::isnan(values[col][row]))
-            {
-                tableWidget->item(row,col)->setText("");
-                tableWidget->item(row,col)->setBackgroundColor(backgroundColor);
-                tableWidget->item(row,col)->setTextColor(textColor);
-            }
-            else
-            {
-                tableWidget->item(row,col)->setText(QString::number(values[col][row], 'g', MAX_DOUBLE_PREC));
-                tableWidget->item(row,col)->setBackgroundColor(VALID_COLOR);
-                tableWidget->item(row,col)->setTextColor(Qt::black);
-            }
-        }
-    }
-
-    disableChecking = false;
-
-    emit valEdited(0,column);
+    emit valEdited(0, colVisualIndex(column));
 }
 
 void DataTable::fillColumnFromRange(int col, Range range)
 {
     double val = range.start;
-    int row = 0;
-    QTableWidgetItem *item;
 
-    col = tableWidget->horizontalHeader()->logicalIndex(col);
-
-    if(col + 1 == tableWidget->columnCount())
-        addColumn();
+    col = colLogicalIndex(col);
 
     int end = trunc((range.end - range.start)/range.step) + 1;
 
     if(end <= 0)
         return;
 
-    disableChecking = true;
+    if(colVisualIndex(col) + 1 == model->columnCount())
+        addColumn();
+    if(end >= model->rowCount())
+        addRows(end + 1 - model->rowCount());
 
-    for(int i = 0 ; i < end ; i++)
+    for(int row = 0 ; row < end ; row++)
     {
-        values[col][row] = val;
-
-        item = tableWidget->item(row, col);
-        item->setText(QString::number(val, 'g', MAX_DOUBLE_PREC));
-        item->setBackgroundColor(VALID_COLOR);
-        item->setTextColor(Qt::black);
-
-        if(tableWidget->rowCount() == row+1)
-            addRow();
-
+        model->setValue(row, col, val);
         val += range.step;
-        row++;
     }
 
-    disableChecking = false;
-    emit valEdited(item->row(), item->column());
+    model->valuesChanged(col, col);
+
+    emit valEdited(end - 1, colVisualIndex(col));
 }
 
 bool DataTable::fillColumnFromExpr(int col, QString expr)
 {
     bool ok = false;
-    FastTree *tree = treeCreator->getTreeFromExpr(expr, ok, columnNames);
+    ByteCode code = treeCreator->getByteCodeFromExpr(expr, ok, columnNames);
 
     if(!ok)
         return false;
 
-    col = tableWidget->horizontalHeader()->logicalIndex(col);
+    col = colLogicalIndex(col);
 
-    if(col + 1 == tableWidget->columnCount())
+    if(colVisualIndex(col) + 1 == model->columnCount())
         addColumn();
 
-    int row = 0;
+    //the expression is evaluated on whole columns, the other columns are read in place as its additionnal variables
 
-    disableChecking = true;
+    QList< QVector<double> > &values = model->getValues();
+    QList<const double*> columns;
 
-    double val;   
-    QList<double> rowVals;
+    for(const QVector<double> &column : values)
+        columns << column.constData();
 
-    for(row = 0 ; row < tableWidget->rowCount() ; row++)
-    {
-        rowVals.clear();
-        for(int column = 0 ; column < tableWidget->columnCount() ; column++) { rowVals << values[column][row];}
+    int rowCount = model->rowCount();
+    const double *x = values[col].constData();
+    QVector<double> results(rowCount);
+    QVector<int> chunksStarts;
 
-        calculator->setAdditionnalVarsValues(rowVals);
-        val = calculator->calculateFromTree(tree, values[col][row]);
-        values[col][row] = val;
-        QTableWidgetItem *item = tableWidget->item(row, col);
+    for(int first = 0 ; first < rowCount ; first += DATA_EXPR_CHUNK_SIZE)
+        chunksStarts << first;
 
-        if(std::isnan(val))
-        {
-            item->setText("");
-            item->setBackgroundColor(backgroundColor);
-            item->setTextColor(textColor);
-        }
-        else
-        {
-            item->setText(QString::number(val, 'g', MAX_DOUBLE_PREC));
-            item->setBackgroundColor(VALID_COLOR);
-            item->setTextColor(Qt::black);
-        }
+    calculator->setAdditionnalVarsColumns(columns);
 
-    }
+    QtConcurrent::blockingMap(chunksStarts, [&](int first) {
+        calculator->calculateColumnFromByteCode(code, x, results.data(), first, qMin(DATA_EXPR_CHUNK_SIZE, rowCount - first));
+    });
+
+    calculator->setAdditionnalVarsColumns(QList<const double*>());
 
-    disableChecking = false;
-    treeCreator->deleteFastTree(tree);
+    values[col] = results;
+    model->clearInvalidCells(col);
+    model->valuesChanged(col, col);
 
-    emit valEdited(row, col);
+    emit valEdited(rowCount - 1, colVisualIndex(col));
     return true;
 
 }
 
 void DataTable::addRow()
 {
-    insertRow(tableWidget->rowCount());
+    insertRow(model->rowCount());
 }
 
-void DataTable::addColumn()
+void DataTable::addRows(int count)
 {
-    insertColumn(tableWidget->columnCount());
+    int oldCount = model->rowCount();
+
+    model->insertRows(oldCount, count);
+
+    emit newRowCount(model->rowCount());
+
+    if(floor(log10(model->rowCount())) != floor(log10(oldCount)))
+    {
+        tableView->verticalHeader()->hide();
+        tableView->verticalHeader()->show();
+    }
+
+    checkVerticalHeaderNewWidth();
 }
 
-QList<QList<double> > &DataTable::getValues()
+void DataTable::addColumn()
 {
-    return values;
+    insertColumn(model->columnCount());
 }
 
-void DataTable::checkCell(QTableWidgetItem *item)
+QList< QVector<double> > &DataTable::getValues()
 {
-    if(disableChecking)
-        return;  
+    return model->getValues();
+}
 
-    if(tableWidget->horizontalHeader()->visualIndex(item->column()) + 1 == tableWidget->columnCount())
+void DataTable::checkCell(int row, int column)
+{
+    if(colVisualIndex(column) + 1 == model->columnCount())
         addColumn();
-    if(item->row()+1 == tableWidget->rowCount())
+    if(row + 1 == model->rowCount())
         addRow();
 
-    QString expr = item->text();
-    if(expr.isEmpty())
-    {
-        item->setBackgroundColor(backgroundColor);
-        item->setTextColor(textColor);
-        values[item->column()][item->row()] = NAN;
-    }
-    else
-    {
-        bool ok = false;
-        double val = calculator->calculateExpression(expr, ok);
-
-        if(ok)
-        {
-            item->setBackgroundColor(VALID_COLOR);
-            item->setTextColor(Qt::black);
-
-            values[item->column()][item->row()] = val;
-            disableChecking = true;
-            item->setText(QString::number(val, 'g', MAX_DOUBLE_PREC));
-            disableChecking = false;
-        }
-        else
-        {
-            item->setBackgroundColor(INVALID_COLOR);
-            item->setTextColor(Qt::black);
-
-            values[item->column()][item->row()] = NAN;
-        }
-    }
-
-    emit valEdited(item->row(), tableWidget->horizontalHeader()->visualIndex(item->column()));
+    emit valEdited(row, colVisualIndex(column));
 }
 
 void DataTable::insertRow(int index)
 {
-    tableWidget->insertRow(index);
-    tableWidget->setRowHeight(index, cellHeight);
+    model->insertRows(index, 1);
 
-    disableChecking = true;
+    emit newRowCount(model->rowCount());
 
-    for(int col = 0 ; col < values.size() ; col++)
-    {
-        QTableWidgetItem *item = new QTableWidgetItem(" ");
-        tableWidget->setItem(index, col, item);
-        values[col].insert(index, NAN);
-    }
-
-    disableChecking = false;
-
-    emit newRowCount(tableWidget->rowCount());
-
-    double count = tableWidget->rowCount();
+    double count = model->rowCount();
 
     if(floor(log(count)/log(10)) != floor(log(count-1)/log(10)))
     {
-        tableWidget->verticalHeader()->hide();
-        tableWidget->verticalHeader()->show();
+        tableView->verticalHeader()->hide();
+        tableView->verticalHeader()->show();
         checkVerticalHeaderNewWidth();
     }
 
@@ -526,59 +423,48 @@ void DataTable::insertRow(int index)
 
 void DataTable::insertColumn(int index)
 {
-    tableWidget->insertColumn(index);
+    model->insertColumns(index, 1);
     columnNames.insert(index, tr("Rename me!"));
-    tableWidget->setHorizontalHeaderLabels(columnNames);
-
-    tableWidget->setColumnWidth(index, cellWidth);
-    int rowCount = values[0].size();
-    values.insert(index, QList<double>());
-
-    disableChecking = true;
-
-    for(int row = 0 ; row < rowCount ; row++)
-    {
-        QTableWidgetItem *item = new QTableWidgetItem(" ");
-        tableWidget->setItem(row, index, item);
-        values[index] << NAN ;
-    }
+    model->setColumnNames(columnNames);
 
-    disableChecking = false;
+    tableView->setColumnWidth(index, cellWidth);
 
-    tableWidget->setFixedWidth(tableWidget->columnCount() * cellWidth + tableWidget->verticalHeader()->width() + 10);
+    updateWidth();
 
-    emit newColumnCount(tableWidget->columnCount());
+    emit newColumnCount(model->columnCount());
 }
 
 void DataTable::removeRow(int index)
 {
-    tableWidget->removeRow(index);
+    int oldCount = model->rowCount();
 
-    for(int col = 0 ; col < values.size() ; col++) { values[col].removeAt(index); }
+    model->removeRows(index, 1);
 
-    emit newRowCount(tableWidget->rowCount());
+    rowCountChanged(oldCount);
+}
 
-    double count = tableWidget->rowCount();
+void DataTable::rowCountChanged(int oldCount)
+{
+    emit newRowCount(model->rowCount());
 
-    if(floor(log(count)/log(10)) != floor(log(count-1)/log(10)))
+    if(floor(log10(model->rowCount())) != floor(log10(oldCount)))
         //this is a correction to a bug in Qt: the vertical header's width doesn't update instantaneously when it visually gets resized
     {
-        tableWidget->verticalHeader()->hide();
-        tableWidget->verticalHeader()->show();
+        tableView->verticalHeader()->hide();
+        tableView->verticalHeader()->show();
         checkVerticalHeaderNewWidth();
     }
 }
 
 void DataTable::removeColumn(int index)
 {
-    tableWidget->removeColumn(index);
+    model->removeColumns(index, 1);
     columnNames.removeAt(index);
+    model->setColumnNames(columnNames);
 
-    values.removeAt(index);
-
-    tableWidget->setFixedWidth(tableWidget->columnCount() * cellWidth + tableWidget->verticalHeader()->width() + 10);    
+    updateWidth();
 
-    emit newColumnCount(tableWidget->columnCount());
+    emit newColumnCount(model->columnCount());
 }
 
 void DataTable::renameColumn(int index)
@@ -595,7 +481,7 @@ void DataTable::renameColumn(int index)
     }
 
     columnNames[index] = name;
-    tableWidget->horizontalHeaderItem(index)->setText(name);
+    model->setColumnNames(columnNames);
 
     emit newColumnName(index);
 
@@ -605,52 +491,55 @@ void DataTable::resizeColumns(int columnWidth)
 {
     cellWidth = columnWidth;
 
-    for(int i = 0 ; i < tableWidget->columnCount(); i++)
+    for(int i = 0 ; i < model->columnCount(); i++)
     {
-        tableWidget->setColumnWidth(i, columnWidth);
+        tableView->setColumnWidth(i, columnWidth);
     }
 
-    tableWidget->setFixedWidth(tableWidget->columnCount() * cellWidth + tableWidget->verticalHeader()->width() + 10);
+    updateWidth();
 }
 
 void DataTable::resizeRows(int rowHeight)
 {
     cellHeight = rowHeight;
 
-    for(int i = 0 ; i < tableWidget->rowCount(); i++)
-    {
-        tableWidget->setRowHeight(i, rowHeight);
-    }    
+    // rows are fixed size: the header doesn't keep a size per row
+    tableView->verticalHeader()->setDefaultSectionSize(rowHeight);
+}
+
+void DataTable::updateWidth()
+{
+    tableView->setFixedWidth(model->columnCount() * cellWidth + tableView->verticalHeader()->width() + tableView->verticalScrollBar()->sizeHint().width() + 10);
 }
 
 int DataTable::colVisualIndex(int logicalIndex)
 {
-    return tableWidget->horizontalHeader()->visualIndex(logicalIndex);
+    return tableView->horizontalHeader()->visualIndex(logicalIndex);
 }
 
 int DataTable::colLogicalIndex(int visualIndex)
 {
-    return tableWidget->horizontalHeader()->logicalIndex(visualIndex);
+    return tableView->horizontalHeader()->logicalIndex(visualIndex);
 }
 
 QSize DataTable::getVerticalHeaderSize()
 {
-    return tableWidget->verticalHeader()->size();
+    return tableView->verticalHeader()->size();
 }
 
 QSize DataTable::getHorizontalHeaderSize()
 {
-    return tableWidget->horizontalHeader()->size();
+    return tableView->horizontalHeader()->size();
 }
 
 int DataTable::getColumnCount()
 {
-    return tableWidget->columnCount();
+    return model->columnCount();
 }
 
 int DataTable::getRowCount()
 {
-    return tableWidget->rowCount();
+    return model->rowCount();
 }
 
 DataTable::~DataTable()
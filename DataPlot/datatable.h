@@ -26,9 +26,12 @@
 #include "structures.h"
 #include "information.h"
 #include "Calculus/exprcalculator.h"
+#include "DataPlot/csvparser.h"
+#include "DataPlot/datatablemodel.h"
 
 #define MIN_ROW_COUNT 10
 #define MIN_COLUMN_COUNT 3
+#define DATA_EXPR_CHUNK_SIZE 16384 // rows evaluated by each task when filling a column from an expression
 
 class DataTable : public QWidget
 {
@@ -45,8 +48,8 @@ public:
     int getColumnCount();
     int getRowCount();
 
-    QList<QStringList> getData();
-    QList<QList<double> > &getValues();
+    CSVData getContent();
+    QList< QVector<double> > &getValues();
 
     void fillColumnFromRange(int col, Range range);
     bool fillColumnFromExpr(int col, QString expr);
@@ -64,7 +67,7 @@ public slots:
     void removeRow(int index);
     void removeColumn(int index);
 
-    void addData(QList<QStringList> data);
+    void addData(const CSVData &data);
 
 signals:
     void newPosCorrections();   
@@ -73,35 +76,37 @@ signals:
     void newColumnName(int visualIndex);
     void valEdited(int row, int column);
     void columnMoved(int logicalIndex, int oldVisualIndex, int newVisualIndex);
+    void verticalScrollOffsetChanged(int offset);
 
 protected slots:
     void renameColumn(int index);
-    void checkCell(QTableWidgetItem *item);
+    void checkCell(int row, int column);
     void checkVerticalHeaderNewWidth();
 
 protected:
     void resizeColumns(int columnWidth);
     void resizeRows(int rowHeight);
+    void updateWidth();
     void addRow();
+    void addRows(int count);
     void addColumn();
     void removeUnnecessaryColumns();
     void removeUnnecessaryRows();
+    QList<QPair<int, int> > unnecessaryRuns(int count, int removable, bool rows);
+    void rowCountChanged(int oldCount);
 
     bool eventFilter(QObject *obj, QEvent *event);
 
 
 
-    bool disableChecking;
     ExprCalculator *calculator;
     TreeCreator *treeCreator;
     int cellHeight, cellWidth, verticalHeaderWidth;
     Information *information;
-    QTableWidget *tableWidget;
-    QList<QList<double> > values; /* values[column][row] since there will be more rows than columns, column insertion is an implemented function in QList
-                                    row insertion will be implemented */
+    QTableView *tableView;
+    DataTableModel *model;
     QStringList columnNames;
     QRegExp nameValidator;
-    QColor backgroundColor, textColor;
 
     
 };
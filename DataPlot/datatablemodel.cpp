@@ -0,0 +1,393 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#include "DataPlot/datatablemodel.h"
+#include <QtConcurrent>
+
+DataTableModel::DataTableModel(ExprCalculator *exprCalculator, int rowCount, int columnCount, QObject *parent) : QAbstractTableModel(parent)
+{
+    calculator = exprCalculator;
+    rows = rowCount;
+
+    for(int col = 0 ; col < columnCount ; col++)
+    {
+        values << QVector<double>(rowCount, NAN);
+        invalidCells << QHash<int, QString>();
+        columnNames << QString();
+    }
+}
+
+int DataTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows;
+}
+
+int DataTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : values.size();
+}
+
+QVariant DataTableModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid())
+        return QVariant();
+
+    int row = index.row(), col = index.column();
+    bool invalid = invalidCells[col].contains(row);
+    bool empty = std::isnan(values[col][row]) && !invalid;
+
+    if(role == Qt::DisplayRole || role == Qt::EditRole)
+        return cellText(row, col);
+    else if(role == Qt::BackgroundRole && !empty)
+        return QColor(invalid ? INVALID_COLOR : VALID_COLOR);
+    else if(role == Qt::ForegroundRole && !empty)
+        return QColor(Qt::black);
+
+    return QVariant();
+}
+
+bool DataTableModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if(!index.isValid() || role != Qt::EditRole)
+        return false;
+
+    int row = index.row(), col = index.column();
+    QString expr = value.toString();
+
+    if(expr.trimmed().isEmpty())
+        setValue(row, col, NAN);
+    else
+    {
+        bool ok = false;
+        double val = calculator->calculateExpression(expr, ok);
+
+        if(ok)
+            setValue(row, col, val);
+        else setInvalidCell(row, col, expr);
+    }
+
+    emit dataChanged(index, index);
+    emit cellEdited(row, col);
+
+    return true;
+}
+
+QVariant DataTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(role != Qt::DisplayRole)
+        return QVariant();
+
+    if(orientation == Qt::Horizontal)
+        return columnNames.value(section);
+    else return section + 1;
+}
+
+Qt::ItemFlags DataTableModel::flags(const QModelIndex &index) const
+{
+    Q_UNUSED(index);
+    return Qt::ItemIsSelectable | Qt::ItemIsEditable | Qt::ItemIsEnabled;
+}
+
+bool DataTableModel::insertRows(int row, int count, const QModelIndex &parent)
+{
+    if(parent.isValid() || row < 0 || row > rows || count <= 0)
+        return false;
+
+    beginInsertRows(parent, row, row + count - 1);
+
+    for(int col = 0 ; col < values.size() ; col++)
+    {
+        values[col].insert(row, count, NAN);
+
+        if(invalidCells[col].isEmpty())
+            continue;
+
+        QHash<int, QString> shifted;
+        for(auto it = invalidCells[col].constBegin() ; it != invalidCells[col].constEnd() ; it++)
+            shifted.insert(it.key() < row ? it.key() : it.key() + count, it.value());
+        invalidCells[col] = shifted;
+    }
+
+    rows += count;
+
+    endInsertRows();
+
+    return true;
+}
+
+bool DataTableModel::removeRows(int row, int count, const QModelIndex &parent)
+{
+    if(parent.isValid() || row < 0 || count <= 0 || row + count > rows)
+        return false;
+
+    beginRemoveRows(parent, row, row + count - 1);
+
+    for(int col = 0 ; col < values.size() ; col++)
+    {
+        values[col].remove(row, count);
+
+        if(invalidCells[col].isEmpty())
+            continue;
+
+        QHash<int, QString> shifted;
+        for(auto it = invalidCells[col].constBegin() ; it != invalidCells[col].constEnd() ; it++)
+        {
+            if(it.key() < row)
+                shifted.insert(it.key(), it.value());
+            else if(it.key() >= row + count)
+                shifted.insert(it.key() - count, it.value());
+        }
+        invalidCells[col] = shifted;
+    }
+
+    rows -= count;
+
+    endRemoveRows();
+
+    return true;
+}
+
+bool DataTableModel::insertColumns(int column, int count, const QModelIndex &parent)
+{
+    if(parent.isValid() || column < 0 || column > values.size() || count <= 0)
+        return false;
+
+    beginInsertColumns(parent, column, column + count - 1);
+
+    for(int i = 0 ; i < count ; i++)
+    {
+        values.insert(column, QVector<double>(rows, NAN));
+        invalidCells.insert(column, QHash<int, QString>());
+        columnNames.insert(column, QString());
+    }
+
+    endInsertColumns();
+
+    return true;
+}
+
+bool DataTableModel::removeColumns(int column, int count, const QModelIndex &parent)
+{
+    if(parent.isValid() || column < 0 || count <= 0 || column + count > values.size())
+        return false;
+
+    beginRemoveColumns(parent, column, column + count - 1);
+
+    for(int i = 0 ; i < count ; i++)
+    {
+        values.removeAt(column);
+        invalidCells.removeAt(column);
+        columnNames.removeAt(column);
+    }
+
+    endRemoveColumns();
+
+    return true;
+}
+
+void DataTableModel::setColumnNames(const QStringList &names)
+{
+    columnNames = names;
+    emit headerDataChanged(Qt::Horizontal, 0, values.size() - 1);
+}
+
+QList< QVector<double> > &DataTableModel::getValues()
+{
+    return values;
+}
+
+QString DataTableModel::cellText(int row, int column) const
+{
+    if(invalidCells[column].contains(row))
+        return invalidCells[column][row];
+    else if(std::isnan(values[column][row]))
+        return QString();
+    else return QString::number(values[column][row], 'g', MAX_DOUBLE_PREC);
+}
+
+const QHash<int, QString> &DataTableModel::getInvalidCells(int column) const
+{
+    return invalidCells[column];
+}
+
+bool DataTableModel::isCellEmpty(int row, int column) const
+{
+    return std::isnan(values[column][row]) && !invalidCells[column].contains(row);
+}
+
+void DataTableModel::setValue(int row, int column, double value)
+{
+    values[column][row] = value;
+
+    if(!invalidCells[column].isEmpty())
+        invalidCells[column].remove(row);
+}
+
+void DataTableModel::setInvalidCell(int row, int column, const QString &text)
+{
+    values[column][row] = NAN;
+    invalidCells[column].insert(row, text);
+}
+
+void DataTableModel::clearInvalidCells(int column)
+{
+    invalidCells[column].clear();
+}
+
+void DataTableModel::valuesChanged(int firstColumn, int lastColumn)
+{
+    if(rows > 0)
+        emit dataChanged(index(0, firstColumn), index(rows - 1, lastColumn));
+}
+
+struct SortKeyLess
+{
+    bool ascending;
+
+    bool operator()(const SortKey &a, const SortKey &b) const
+    {
+        // ties are broken by row, which keeps the sort stable
+        if(a.value == b.value)
+            return a.row < b.row;
+        else return ascending ? a.value < b.value : a.value > b.value;
+    }
+};
+
+QVector<int> DataTableModel::sortedRows(int column, bool ascending) const
+{
+    // rows in the order that sorts "column", empty cells being left at the end in their current order
+
+    const QVector<double> &col = values[column];
+    QVector<SortKey> keys;
+    QVector<int> order;
+
+    keys.reserve(rows);
+    order.reserve(rows);
+
+    for(int row = 0 ; row < rows ; row++)
+    {
+        if(!std::isnan(col[row]))
+        {
+            SortKey key;
+            key.value = col[row];
+            key.row = row;
+            keys << key;
+        }
+    }
+
+    // runs of rows are sorted in parallel, then merged two by two, each pass merging its pairs in parallel
+
+    SortKeyLess less;
+    less.ascending = ascending;
+
+    int n = keys.size();
+    int runSize = qMax(DATA_SORT_MIN_RUN, n / qMax(1, QThread::idealThreadCount()) + 1);
+    QVector<int> starts;
+
+    for(int start = 0 ; start < n ; start += runSize)
+        starts << start;
+
+    SortKey *data = keys.data();
+
+    QtConcurrent::blockingMap(starts, [=](int start) {
+        std::sort(data + start, data + qMin(start + runSize, n), less);
+    });
+
+    QVector<SortKey> merged(n);
+
+    for( ; runSize < n ; runSize *= 2)
+    {
+        SortKey *source = keys.data(), *target = merged.data();
+
+        starts.clear();
+        for(int start = 0 ; start < n ; start += 2 * runSize)
+            starts << start;
+
+        QtConcurrent::blockingMap(starts, [=](int start) {
+            int middle = qMin(start + runSize, n), end = qMin(start + 2 * runSize, n);
+            std::merge(source + start, source + middle, source + middle, source + end, target + start, less);
+        });
+
+        keys.swap(merged);
+    }
+
+    for(const SortKey &key : keys)
+        order << key.row;
+
+    for(int row = 0 ; row < rows ; row++)
+        if(std::isnan(col[row]))
+            order << row;
+
+    return order;
+}
+
+void DataTableModel::reorderRows(const QVector<int> &order)
+{
+    // row i receives the former row order[i], in every column
+
+    QVector<int> newRows(rows), columns;
+
+    for(int row = 0 ; row < rows ; row++)
+        newRows[order[row]] = row;
+
+    for(int col = 0 ; col < values.size() ; col++)
+        columns << col;
+
+    beginResetModel();
+
+    QtConcurrent::blockingMap(columns, [&](int col) { gatherColumn(col, order, newRows); });
+
+    endResetModel();
+}
+
+void DataTableModel::reorderColumn(int column, const QVector<int> &order)
+{
+    QVector<int> newRows(rows);
+
+    for(int row = 0 ; row < rows ; row++)
+        newRows[order[row]] = row;
+
+    beginResetModel();
+    gatherColumn(column, order, newRows);
+    endResetModel();
+}
+
+void DataTableModel::gatherColumn(int column, const QVector<int> &order, const QVector<int> &newRows)
+{
+    QVector<double> gathered(rows);
+    const double *col = values[column].constData();
+
+    for(int row = 0 ; row < rows ; row++)
+        gathered[row] = col[order[row]];
+
+    values[column].swap(gathered);
+
+    if(invalidCells[column].isEmpty())
+        return;
+
+    QHash<int, QString> moved;
+    for(auto it = invalidCells[column].constBegin() ; it != invalidCells[column].constEnd() ; it++)
+        moved.insert(newRows[it.key()], it.value());
+    invalidCells[column] = moved;
+}
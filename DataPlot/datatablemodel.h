@@ -0,0 +1,92 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#ifndef DATATABLEMODEL_H
+#define DATATABLEMODEL_H
+
+#include "structures.h"
+#include "Calculus/exprcalculator.h"
+
+#define DATA_SORT_MIN_RUN 16384 // rows sorted by each task before the runs get merged
+
+struct SortKey
+{
+    double value;
+    int row;
+};
+
+/* Cells of the data table, stored as one contiguous array of doubles per column: the view asks only for
+   the cells it paints, their text is made on the fly. Cells whose text couldn't be evaluated are the only
+   ones keeping a string, in a per column overlay, their value is NAN. */
+
+class DataTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    DataTableModel(ExprCalculator *exprCalculator, int rowCount, int columnCount, QObject *parent = NULL);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole);
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+    Qt::ItemFlags flags(const QModelIndex &index) const;
+
+    bool insertRows(int row, int count, const QModelIndex &parent = QModelIndex());
+    bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex());
+    bool insertColumns(int column, int count, const QModelIndex &parent = QModelIndex());
+    bool removeColumns(int column, int count, const QModelIndex &parent = QModelIndex());
+
+    void setColumnNames(const QStringList &names);
+
+    QList< QVector<double> > &getValues();
+    QString cellText(int row, int column) const;
+    const QHash<int, QString> &getInvalidCells(int column) const;
+    bool isCellEmpty(int row, int column) const;
+
+    void setValue(int row, int column, double value);
+    void setInvalidCell(int row, int column, const QString &text);
+    void clearInvalidCells(int column);
+    void valuesChanged(int firstColumn, int lastColumn); // to call once values were written directly
+
+    QVector<int> sortedRows(int column, bool ascending) const;
+    void reorderRows(const QVector<int> &order);
+    void reorderColumn(int column, const QVector<int> &order);
+
+signals:
+    void cellEdited(int row, int column);
+
+protected:
+    void gatherColumn(int column, const QVector<int> &order, const QVector<int> &newRows);
+
+    ExprCalculator *calculator;
+    QList< QVector<double> > values; // values[column][row]
+    QList< QHash<int, QString> > invalidCells; // invalidCells[column][row]
+    QStringList columnNames;
+    int rows;
+};
+
+#endif // DATATABLEMODEL_H
@@ -73,7 +73,7 @@ DataWindow::DataWindow(Information *info, int ind)
     dataTable = new DataTable(info, STARTING_ROW_COUNT, STARTING_COLUMN_COUNT, ROW_HEIGHT, COLUMN_WIDTH);
     columnSelector = new ColumnSelectorWidget(STARTING_COLUMN_COUNT, STARTING_XPIN_INDEX, STARTING_YPIN_INDEX, STARTING_SELECTOR_INDEX);
     columnActionsWidget = new ColumnActionsWidget(dataTable, info, STARTING_COLUMN_COUNT);
-    rowSelector = new RowSelectorWidget(STARTING_ROW_COUNT);
+    rowSelector = new RowSelectorWidget(STARTING_ROW_COUNT, ROW_HEIGHT);
     rowActionsWidget = new RowActionsWidget(STARTING_ROW_COUNT);
 
 
@@ -98,8 +98,7 @@ DataWindow::DataWindow(Information *info, int ind)
     rowSelector->setFixedWidth(ROW_SELECTOR_WIDTH);
 
     rowSelectorLayout->addWidget(rowSelectorSpacer);
-    rowSelectorLayout->addWidget(rowSelector);
-    rowSelectorLayout->addStretch();
+    rowSelectorLayout->addWidget(rowSelector); // as high as the table, which scrolls its rows itself
 
 
     QHBoxLayout *secondLayout = new QHBoxLayout();
@@ -110,8 +109,7 @@ DataWindow::DataWindow(Information *info, int ind)
     secondLayout->addWidget(dataTable);
 
 
-    ui->tableLayout->addLayout(secondLayout);
-    ui->tableLayout->addStretch();
+    ui->tableLayout->addLayout(secondLayout, 1);
 
     updateSelectorsSize();
 
@@ -128,7 +126,8 @@ DataWindow::DataWindow(Information *info, int ind)
     rowActionsWidget->hide();
 
     csvHandler = new CSVhandler(this);
-    connect(csvHandler, SIGNAL(dataFromCSV(QList<QStringList>)), dataTable, SLOT(addData(QList<QStringList>)));
+    connect(csvHandler, SIGNAL(dataFromCSV(CSVData)), dataTable, SLOT(addData(CSVData)));
+    connect(csvHandler, SIGNAL(dataFromCSV(CSVData)), this, SLOT(remakeDataList())); // once the whole file is in the table
 
     connect(ui->open, SIGNAL(released()), this, SLOT(openData()));
     connect(ui->save, SIGNAL(released()), this, SLOT(saveData()));
@@ -155,6 +154,7 @@ DataWindow::DataWindow(Information *info, int ind)
     connect(dataTable, SIGNAL(newColumnCount(int)), columnSelector, SLOT(setColumnCount(int)));
     connect(dataTable, SIGNAL(newColumnCount(int)), columnActionsWidget, SLOT(setColumnCount(int)));
     connect(dataTable, SIGNAL(newRowCount(int)), rowSelector, SLOT(setRowCount(int)));
+    connect(dataTable, SIGNAL(verticalScrollOffsetChanged(int)), rowSelector, SLOT(setScrollOffset(int)));
     connect(dataTable, SIGNAL(newRowCount(int)), rowActionsWidget, SLOT(setRowCount(int)));
     connect(dataTable, SIGNAL(valEdited(int,int)), this, SLOT(cellValChanged(int,int)));
     connect(dataTable, SIGNAL(newColumnName(int)), this, SLOT(columnNameChanged(int)));
@@ -319,7 +319,7 @@ void DataWindow::cellValChanged(int row, int col)
 
 void DataWindow::remakeDataList()
 {
-    const QList<QList<double> > &values = dataTable->getValues();
+    const QList< QVector<double> > &values = dataTable->getValues();
     QList<QPointF> dataList;
     QPointF point;
 
@@ -372,7 +372,7 @@ void DataWindow::openData()
 
 void DataWindow::saveData()
 {
-    csvHandler->saveCSV(dataTable->getData());
+    csvHandler->saveData(dataTable->getContent());
 }
 
 void DataWindow::selectorInColumnSelection()
@@ -417,7 +417,6 @@ void DataWindow::updateSelectorsSize()
     rowSelectorSpacer->setFixedHeight(dataTable->getHorizontalHeaderSize().height());
 
     columnSelector->setFixedWidth(dataTable->getColumnCount()*COLUMN_WIDTH);
-    rowSelector->setFixedHeight(dataTable->getRowCount()*ROW_HEIGHT);
 }
 
 DataWindow::~DataWindow()
@@ -22,9 +22,11 @@
 
 #include "DataPlot/rowselectorwidget.h"
 
-RowSelectorWidget::RowSelectorWidget(int count)
+RowSelectorWidget::RowSelectorWidget(int count, int height)
 {
     rowCount = count;
+    rowHeight = height;
+    scrollOffset = 0;
 
     selector.index = 0;
     selector.draw = false;
@@ -35,10 +37,15 @@ RowSelectorWidget::RowSelectorWidget(int count)
     connect(&timer, SIGNAL(timeout()), this, SLOT(updateAnimationProgress()));
 }
 
+int RowSelectorWidget::contentHeight()
+{
+    return rowCount * rowHeight;
+}
+
 void RowSelectorWidget::updateSelectorsPos()
 {
     selector.pos.setX(width() - selector.image.width());
-    selector.pos.setY(selector.index*height()/rowCount + selector.image.height()/2);
+    selector.pos.setY(selector.index*rowHeight + selector.image.height()/2);
 }
 
 void RowSelectorWidget::askedForSelector()
@@ -66,24 +73,26 @@ void RowSelectorWidget::paintEvent(QPaintEvent *event)
     painter.begin(this);
 
     if(selector.draw)
-        painter.drawImage(selector.pos, selector.image);
+        painter.drawImage(selector.pos - QPoint(0, scrollOffset), selector.image);
 
     painter.end();
 }
 
 void RowSelectorWidget::mouseMoveEvent(QMouseEvent *event)
 {
-    if(event->y() >= height() - selector.image.height()/2)
+    int y = event->y() + scrollOffset;
+
+    if(y >= contentHeight() - selector.image.height()/2)
     {
-        selector.pos.setY(height() - selector.image.height());
+        selector.pos.setY(contentHeight() - selector.image.height());
     }
-    else if(event->y() <= selector.image.height()/2)
+    else if(y <= selector.image.height()/2)
     {
         selector.pos.setY(0);
     }
     else
     {
-        selector.pos.setY(event->y() - selector.image.height()/2);
+        selector.pos.setY(y - selector.image.height()/2);
     }
 
      repaint();
@@ -91,23 +100,25 @@ void RowSelectorWidget::mouseMoveEvent(QMouseEvent *event)
 
 void RowSelectorWidget::mousePressEvent(QMouseEvent *event)
 {
+    int y = event->y() + scrollOffset;
+
     if(!selector.draw)
     {
         selector.draw = true;
         emit askForSelector();
     }
 
-    if(event->y() >= height() - selector.image.height()/2)
+    if(y >= contentHeight() - selector.image.height()/2)
     {
-        selector.pos.setY(height() - selector.image.height()/2);
+        selector.pos.setY(contentHeight() - selector.image.height()/2);
     }
-    else if(event->y() <= selector.image.height()/2)
+    else if(y <= selector.image.height()/2)
     {
         selector.pos.setY(selector.image.height()/2);
     }
     else
     {
-        selector.pos.setY(event->y() - selector.image.height()/2);
+        selector.pos.setY(y - selector.image.height()/2);
     }
 
     repaint();
@@ -118,10 +129,10 @@ void RowSelectorWidget::mouseReleaseEvent(QMouseEvent *event)
     Q_UNUSED(event);
 
     int y = selector.pos.y() + selector.image.height()/2;
-    int index = y * rowCount / height();
-    int ordinate = index * height() / rowCount + height()/rowCount/2;
+    int index = qBound(0, y / rowHeight, rowCount - 1);
+    int ordinate = index * rowHeight + rowHeight/2;
 
-    if((index == 0 && y <= 3*height()/rowCount/4) || (index == rowCount-1 && y >= height()-3*height()/rowCount/4) || abs(y - ordinate) <= height()/rowCount/4) //nearest to the center of the column
+    if((index == 0 && y <= 3*rowHeight/4) || (index == rowCount-1 && y >= contentHeight()-3*rowHeight/4) || abs(y - ordinate) <= rowHeight/4) //nearest to the center of the column
     {
         selector.index = index;
         selector.betweenRows = false;
@@ -135,7 +146,7 @@ void RowSelectorWidget::mouseReleaseEvent(QMouseEvent *event)
         selector.betweenRows = true;
         selector.animation.progress = 0;
         selector.animation.departureOrdinate = selector.pos.y();
-        selector.animation.arrivalOrdinate = index * height() / rowCount - selector.image.height()/2;
+        selector.animation.arrivalOrdinate = index * rowHeight - selector.image.height()/2;
     }
     else //nearer to index+1
     {
@@ -143,7 +154,7 @@ void RowSelectorWidget::mouseReleaseEvent(QMouseEvent *event)
         selector.betweenRows = true;
         selector.animation.progress = 0;
         selector.animation.departureOrdinate = selector.pos.y();
-        selector.animation.arrivalOrdinate = (index+1) * height() / rowCount - selector.image.height()/2;
+        selector.animation.arrivalOrdinate = (index+1) * rowHeight - selector.image.height()/2;
     }
 
     emit newIndex(selector.betweenRows, selector.index);
@@ -156,3 +167,9 @@ void RowSelectorWidget::setRowCount(int count)
 {    
     rowCount = count;
 }
+
+void RowSelectorWidget::setScrollOffset(int offset)
+{
+    scrollOffset = offset;
+    update();
+}
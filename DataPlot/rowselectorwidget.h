@@ -50,11 +50,12 @@ class RowSelectorWidget : public QWidget
 {
     Q_OBJECT
 public:
-    explicit RowSelectorWidget(int count);
+    explicit RowSelectorWidget(int count, int height);
     void updateSelectorsPos();
 
 public slots:
     void setRowCount(int count);
+    void setScrollOffset(int offset);
     void askedForSelector();   
 
 signals:
@@ -66,6 +67,7 @@ protected slots:
 
 protected:
     void drawSelectors();
+    int contentHeight();
 
     void paintEvent(QPaintEvent *event);
     void mouseMoveEvent(QMouseEvent *event);
@@ -74,7 +76,7 @@ protected:
 
     QPainter painter;
     QTimer timer;
-    int rowCount;
+    int rowCount, rowHeight, scrollOffset; // the selector's ordinates are in the table's content, offset by its scrolling
     bool hasSelector;
     RowSelector selector;
 };
@@ -0,0 +1,272 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#include "GraphDraw/curvestiles.h"
+#include <QtConcurrent>
+
+#define TILE_COST (TILE_SIZE * TILE_SIZE * 4 / 1024) // ARGB32 tiles, in KB
+
+CurvesTiles::CurvesTiles() : tiles(TILES_CACHE_MAX_KB)
+{
+    generation = 0;
+    lastXUnit = lastYUnit = 0;
+
+    content.xMin = content.xMax = 0;
+    content.thickness = 1;
+    content.calculationId = -1;
+    content.smoothing = true;
+}
+
+CurvesTiles::~CurvesTiles()
+{
+    pool.clear();
+    pool.waitForDone();
+}
+
+void CurvesTiles::setContent(const TilesContent &newContent, bool restyled)
+{
+    if(restyled || newContent.calculationId != content.calculationId)
+    {
+        generation++;
+
+        pool.clear(); // the tiles waiting to be rendered are outdated
+        pending.clear();
+    }
+
+    // otherwise the curves have only been moved: the tiles they already covered stay valid
+    content = newContent;
+}
+
+QRectF CurvesTiles::tileRect(const TileKey &key)
+{
+    return QRectF(key.x * TILE_SIZE, key.y * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+}
+
+bool CurvesTiles::getCoverage(const TileKey &key, double &xMin, double &xMax)
+{
+    QRectF rect = tileRect(key);
+
+    xMin = qMax(rect.left() / key.xUnit, content.xMin);
+    xMax = qMin(rect.right() / key.xUnit, content.xMax);
+
+    return xMin < xMax;
+}
+
+void CurvesTiles::requestTile(const TileKey &key)
+{
+    Tile tile;
+
+    if(!getCoverage(key, tile.xMin, tile.xMax))
+        return;
+
+    tile.generation = generation;
+
+    if(pending.contains(key))
+    {
+        const Tile &requested = pending[key];
+
+        if(requested.generation == tile.generation && requested.xMin == tile.xMin && requested.xMax == tile.xMax)
+            return;
+    }
+
+    pending.insert(key, tile);
+
+    TilesContent tileContent = content;
+    QRectF rect = tileRect(key);
+
+    QtConcurrent::run(&pool, [this, tileContent, key, rect, tile]() mutable
+    {
+        tile.image = QImage(TILE_SIZE, TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
+        tile.image.fill(Qt::transparent);
+
+        QPainter tilePainter(&tile.image);
+        tilePainter.translate(-rect.topLeft());
+        renderCurves(tilePainter, tileContent, key.xUnit, key.yUnit, rect);
+        tilePainter.end();
+
+        renderedMutex.lock();
+        rendered << qMakePair(key, tile);
+        renderedMutex.unlock();
+
+        emit tilesRendered();
+    });
+}
+
+void CurvesTiles::collectRenderedTiles()
+{
+    QList< QPair<TileKey, Tile> > newTiles;
+
+    renderedMutex.lock();
+    newTiles.swap(rendered);
+    renderedMutex.unlock();
+
+    for(int i = 0 ; i < newTiles.size() ; i++)
+    {
+        const TileKey &key = newTiles[i].first;
+        const Tile &tile = newTiles[i].second;
+
+        if(pending.contains(key) && pending[key].generation == tile.generation &&
+                pending[key].xMin == tile.xMin && pending[key].xMax == tile.xMax)
+            pending.remove(key);
+
+        if(tile.generation == generation)
+            tiles.insert(key, new Tile(tile), TILE_COST);
+    }
+}
+
+void CurvesTiles::draw(QPainter &painter, QRectF visible, double xUnit, double yUnit, QPoint dragDirection)
+{
+    collectRenderedTiles();
+
+    if(xUnit != lastXUnit || yUnit != lastYUnit)
+    {
+        pool.clear(); // the tiles of the previous scale won't be needed
+        pending.clear();
+
+        lastXUnit = xUnit;
+        lastYUnit = yUnit;
+    }
+
+    double tileLeft = floor(visible.left() / TILE_SIZE), tileRight = floor(visible.right() / TILE_SIZE);
+    double tileTop = floor(visible.top() / TILE_SIZE), tileBottom = floor(visible.bottom() / TILE_SIZE);
+
+    // also false for NaNs
+    if(!(qAbs(tileLeft) < TILE_INDEX_MAX && qAbs(tileRight) < TILE_INDEX_MAX &&
+         qAbs(tileTop) < TILE_INDEX_MAX && qAbs(tileBottom) < TILE_INDEX_MAX))
+    {
+        renderCurves(painter, content, xUnit, yUnit, visible);
+        return;
+    }
+
+    qint64 left = tileLeft, right = tileRight, top = tileTop, bottom = tileBottom;
+
+    TileKey key;
+    key.xUnit = xUnit;
+    key.yUnit = yUnit;
+
+    QRegion missing;
+    Tile *tile;
+    double xMin, xMax;
+
+    for(key.y = top ; key.y <= bottom ; key.y++)
+    {
+        for(key.x = left ; key.x <= right ; key.x++)
+        {
+            tile = tiles.object(key);
+
+            if(tile != NULL)
+                painter.drawImage(tileRect(key).topLeft(), tile->image);
+            else missing += tileRect(key).toAlignedRect();
+
+            // tiles from an older generation, or that the curves now cover better, are drawn until they are replaced
+            if(tile == NULL || tile->generation != generation ||
+                    (getCoverage(key, xMin, xMax) && (xMin != tile->xMin || xMax != tile->xMax)))
+                requestTile(key);
+        }
+    }
+
+    for(int i = 1 ; i <= TILES_PREFETCH ; i++)
+    {
+        if(dragDirection.x() != 0)
+        {
+            key.x = dragDirection.x() > 0 ? right + i : left - i;
+
+            for(key.y = top ; key.y <= bottom ; key.y++)
+                if(!tiles.contains(key))
+                    requestTile(key);
+        }
+
+        if(dragDirection.y() != 0)
+        {
+            key.y = dragDirection.y() > 0 ? bottom + i : top - i;
+
+            for(key.x = left ; key.x <= right ; key.x++)
+                if(!tiles.contains(key))
+                    requestTile(key);
+        }
+    }
+
+    if(!missing.isEmpty())
+    {
+        painter.save();
+        painter.setClipRegion(missing, Qt::IntersectClip);
+        renderCurves(painter, content, xUnit, yUnit, visible);
+        painter.restore();
+    }
+}
+
+void CurvesTiles::renderCurves(QPainter &painter, const TilesContent &content, double xUnit, double yUnit, QRectF rect)
+{
+    // the curves are in view coordinates, the painter's are pixels from the view's origin, y pointing down
+    // a pen's width around the rect is drawn too, so that strokes aren't cut along the tiles' edges
+
+    double margin = content.thickness / xUnit;
+    double xMin = qMax(rect.left() / xUnit - margin, content.xMin);
+    double xMax = qMin(rect.right() / xUnit + margin, content.xMax);
+
+    if(xMin >= xMax)
+        return;
+
+    QPen pen;
+    pen.setCapStyle(Qt::RoundCap);
+    pen.setWidth(content.thickness);
+
+    painter.setRenderHint(QPainter::Antialiasing, content.smoothing);
+
+    QPolygonF part;
+    int start, end;
+
+    for(int func = 0 ; func < content.curves.size() ; func++)
+    {
+        if(content.colors[func].isEmpty())
+            continue;
+
+        for(int curve = 0 ; curve < content.curves[func].size() ; curve++)
+        {
+            const CurveBuffer &points = content.curves[func][curve];
+
+            start = qMax(0, points.lowerBound(xMin) - 1);
+            end = qMin(points.size(), points.lowerBound(xMax) + 1);
+
+            pen.setColor(content.colors[func].value(curve));
+            painter.setPen(pen);
+
+            part.clear();
+
+            for(int i = start ; i < end ; i++)
+            {
+                if(points.isBreak(i) && !part.isEmpty())
+                {
+                    painter.drawPolyline(part);
+                    part.clear();
+                }
+
+                part << QPointF(points.at(i).x() * xUnit, - points.at(i).y() * yUnit);
+            }
+
+            if(!part.isEmpty())
+                painter.drawPolyline(part);
+        }
+    }
+}
@@ -0,0 +1,107 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#ifndef CURVESTILES_H
+#define CURVESTILES_H
+
+#include "structures.h"
+#include "Calculus/curvebuffer.h"
+
+#define TILE_SIZE 256 // pixels
+#define TILES_CACHE_MAX_KB 65536 // 256 tiles, the least recently drawn ones are dropped beyond that
+#define TILES_PREFETCH 1 // rows or columns of tiles rendered ahead of the view, in the direction it is dragged
+#define TILE_INDEX_MAX (Q_INT64_C(1) << 44) // beyond, tile corners in pixels lose their precision: the view is drawn directly
+
+struct TileKey // tiles are anchored to the origin of the view coordinates, at a given scale
+{
+    double xUnit, yUnit;
+    qint64 x, y; // deep zooms far from the origin put pixel coordinates well beyond the int range
+
+    bool operator==(const TileKey &other) const
+    {
+        return xUnit == other.xUnit && yUnit == other.yUnit && x == other.x && y == other.y;
+    }
+};
+
+inline uint qHash(const TileKey &key, uint seed = 0)
+{
+    return qHash(key.xUnit, seed) ^ qHash(key.yUnit, seed + 1) ^ qHash(key.x, seed + 2) ^ qHash(key.y, seed + 3);
+}
+
+struct TilesContent // what tiles are drawn from: copies are cheap, the curves are implicitly shared
+{
+    QList< QList<CurveBuffer> > curves;
+    QList< QList<QColor> > colors; // empty for the functions that aren't drawn
+    double xMin, xMax; // abscissas covered by the curves, in view coordinates
+    int thickness, calculationId;
+    bool smoothing;
+};
+
+struct Tile
+{
+    QImage image;
+    int generation;
+    double xMin, xMax; // part of the tile the curves covered when it was rendered
+};
+
+/* Function curves rasterized in fixed size tiles, rendered by a thread pool from a TilesContent.
+   Panning with unchanged curves only blits cached tiles. A new calculation of the curves, or a
+   change of their style, starts a new generation: older tiles are still drawn while the new ones
+   are rendered, and tiles never rendered are drawn directly meanwhile. */
+
+class CurvesTiles : public QObject
+{
+    Q_OBJECT
+
+public:
+    CurvesTiles();
+    ~CurvesTiles();
+
+    void setContent(const TilesContent &newContent, bool restyled);
+    void draw(QPainter &painter, QRectF visible, double xUnit, double yUnit, QPoint dragDirection);
+
+    static void renderCurves(QPainter &painter, const TilesContent &content, double xUnit, double yUnit, QRectF rect);
+
+signals:
+    void tilesRendered();
+
+protected:
+    void collectRenderedTiles();
+    void requestTile(const TileKey &key);
+    QRectF tileRect(const TileKey &key);
+    bool getCoverage(const TileKey &key, double &xMin, double &xMax);
+
+    TilesContent content;
+    int generation;
+    double lastXUnit, lastYUnit;
+
+    QCache<TileKey, Tile> tiles;
+    QHash<TileKey, Tile> pending; // requested tiles: generation and coverage they will have, without the image
+    QThreadPool pool;
+
+    QMutex renderedMutex;
+    QList< QPair<TileKey, Tile> > rendered;
+};
+
+#endif // CURVESTILES_H
@@ -0,0 +1,185 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#include "GraphDraw/datasetlod.h"
+
+static bool abscissaLess(const QPointF &a, const QPointF &b)
+{
+    return a.x() < b.x();
+}
+
+static double columnOf(double x, double xMin, double xMax, double cellWidth)
+{
+    // every point out of [xMin, xMax] falls in one of two columns: segments between them can't be seen
+    if(x < xMin)
+        return -INFINITY;
+    if(x > xMax)
+        return INFINITY;
+    return floor((x - xMin) / cellWidth);
+}
+
+DataSetLod::DataSetLod()
+{
+    DataLodLevel level;
+    level.cellWidth = level.cellHeight = 0;
+    levels << level;
+}
+
+DataSetLod::DataSetLod(const QList<QPointF> &data)
+{
+    DataLodLevel level;
+    level.cellWidth = level.cellHeight = 0;
+    level.line = QPolygonF(QVector<QPointF>::fromList(data));
+    level.markers = level.line;
+    std::sort(level.markers.begin(), level.markers.end(), abscissaLess);
+    levels << level;
+
+    if(data.isEmpty())
+        return;
+
+    bounds = level.line.boundingRect();
+    double width = bounds.width() > 0 ? bounds.width() : 1;
+    double height = bounds.height() > 0 ? bounds.height() : 1;
+
+    for(int bins = DATA_LOD_FINEST_BINS ; bins >= DATA_LOD_COARSEST_BINS ; bins /= 2)
+    {
+        const DataLodLevel &finer = levels.last();
+        if(finer.line.size() < DATA_LOD_MIN_POINTS && finer.markers.size() < DATA_LOD_MIN_POINTS)
+            break;
+
+        DataLodLevel coarser;
+        coarser.cellWidth = width / bins;
+        coarser.cellHeight = height / bins;
+
+        // the cells of a level are made of whole cells of the finer one, reducing it is enough
+        reduceLine(finer.line, bounds.left(), bounds.right(), coarser.cellWidth, coarser.line);
+        reduceMarkers(finer.markers, bounds, coarser.cellWidth, coarser.cellHeight, coarser.markers);
+
+        levels << coarser;
+    }
+}
+
+int DataSetLod::size() const
+{
+    return levels.first().line.size();
+}
+
+const DataLodLevel& DataSetLod::getLevel(double cellWidth, double cellHeight) const
+{
+    for(int i = levels.size() - 1 ; i > 0 ; i--)
+        if(levels[i].cellWidth <= cellWidth && levels[i].cellHeight <= cellHeight)
+            return levels[i];
+
+    return levels.first();
+}
+
+QPolygonF DataSetLod::getPolyline(const QRectF &visible, double pixelWidth) const
+{
+    if(pixelWidth <= 0 || size() < DATA_LOD_MIN_POINTS)
+        return levels.first().line;
+
+    QPolygonF polyline;
+    reduceLine(getLevel(pixelWidth / DATA_LOD_OVERSAMPLING, INFINITY).line, visible.left(), visible.right(), pixelWidth, polyline);
+    return polyline;
+}
+
+QPolygonF DataSetLod::getMarkers(const QRectF &visible, double cellWidth, double cellHeight) const
+{
+    if(cellWidth <= 0 || cellHeight <= 0 || size() < DATA_LOD_MIN_POINTS)
+        return levels.first().markers;
+
+    QPolygonF markers;
+    reduceMarkers(getLevel(cellWidth, cellHeight).markers, visible.adjusted(-cellWidth, -cellHeight, cellWidth, cellHeight),
+                  cellWidth, cellHeight, markers);
+    return markers;
+}
+
+void DataSetLod::reduceLine(const QPolygonF &line, double xMin, double xMax, double cellWidth, QPolygonF &reduced)
+{
+    reduced.clear();
+
+    if(line.isEmpty())
+        return;
+
+    int first = 0, lowest = 0, highest = 0;
+    double column = columnOf(line[0].x(), xMin, xMax, cellWidth);
+
+    for(int i = 1 ; i <= line.size() ; i++)
+    {
+        if(i < line.size())
+        {
+            double pointColumn = columnOf(line[i].x(), xMin, xMax, cellWidth);
+
+            if(pointColumn == column)
+            {
+                if(line[i].y() < line[lowest].y())
+                    lowest = i;
+                if(line[i].y() > line[highest].y())
+                    highest = i;
+                continue;
+            }
+
+            column = pointColumn;
+        }
+
+        // the run of points in the previous column ended at i-1, its four extreme points are kept in order
+        int kept[4] = {first, qMin(lowest, highest), qMax(lowest, highest), i - 1};
+
+        for(int k = 0 ; k < 4 ; k++)
+            if(k == 0 || kept[k] != kept[k-1])
+                reduced << line[kept[k]];
+
+        first = lowest = highest = i;
+    }
+}
+
+void DataSetLod::reduceMarkers(const QPolygonF &markers, const QRectF &area, double cellWidth, double cellHeight,
+                               QPolygonF &reduced)
+{
+    reduced.clear();
+
+    QSet<qint64> columnRows; // rows already occupied in the current column
+    double column = NAN;
+
+    for(auto it = std::lower_bound(markers.begin(), markers.end(), area.topLeft(), abscissaLess) ;
+        it != markers.end() && it->x() <= area.right() ; it++)
+    {
+        if(it->y() < area.top() || it->y() > area.bottom())
+            continue;
+
+        double pointColumn = floor((it->x() - area.left()) / cellWidth);
+        if(pointColumn != column)
+        {
+            column = pointColumn;
+            columnRows.clear();
+        }
+
+        qint64 row = qint64((it->y() - area.top()) / cellHeight);
+        if(!columnRows.contains(row))
+        {
+            columnRows.insert(row);
+            reduced << *it;
+        }
+    }
+}
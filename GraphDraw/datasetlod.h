@@ -0,0 +1,70 @@
+/****************************************************************************
+**  Copyright (c) 2016, Adel Kara Slimane <adel.ks@zegrapher.com>
+**
+**  This file is part of ZeGrapher's source code.
+**
+**  ZeGrapher is free software: you may copy, redistribute and/or modify it
+**  under the terms of the GNU General Public License as published by the
+**  Free Software Foundation, either version 3 of the License, or (at your
+**  option) any later version.
+**
+**  This file is distributed in the hope that it will be useful, but
+**  WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+**  General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+
+
+
+#ifndef DATASETLOD_H
+#define DATASETLOD_H
+
+#include "structures.h"
+
+#define DATA_LOD_MIN_POINTS 2048 // data sets, or levels, smaller than that aren't reduced further
+#define DATA_LOD_FINEST_BINS 65536 // abscissa bins of the finest reduced level, each next level halves them
+#define DATA_LOD_COARSEST_BINS 64
+#define DATA_LOD_OVERSAMPLING 8 // cells of the level a polyline is reduced from per pixel column
+
+struct DataLodLevel
+{
+    double cellWidth, cellHeight; // size of the cells the level was reduced with, in data units
+    QPolygonF line; // min/max per column of cells, the points keep the order of the data set
+    QPolygonF markers; // one point per occupied cell, sorted by abscissa
+};
+
+/* Multi-resolution pyramid of a data set, built once when the data is set. Level 0 holds every
+   point, each next level merges the cells of the previous one two by two. Drawing picks the
+   coarsest level that is still finer than a pixel, and reduces it again to the pixels of the view:
+   the polyline keeps the first, lowest, highest and last points of each pixel column, so it looks
+   the same as the full one, and markers keep one point per cell of the given size. Level cells
+   straddling two columns may lose an extreme point, hence several of them per column. */
+
+class DataSetLod
+{
+public:
+    DataSetLod();
+    explicit DataSetLod(const QList<QPointF> &data);
+
+    int size() const;
+
+    QPolygonF getPolyline(const QRectF &visible, double pixelWidth) const;
+    QPolygonF getMarkers(const QRectF &visible, double cellWidth, double cellHeight) const;
+
+protected:
+    static void reduceLine(const QPolygonF &line, double xMin, double xMax, double cellWidth, QPolygonF &reduced);
+    static void reduceMarkers(const QPolygonF &markers, const QRectF &area, double cellWidth, double cellHeight,
+                              QPolygonF &reduced);
+    const DataLodLevel& getLevel(double cellWidth, double cellHeight) const;
+
+    QList<DataLodLevel> levels;
+    QRectF bounds; // with a positive height: top is the lowest ordinate
+};
+
+#endif // DATASETLOD_H
@@ -120,19 +120,27 @@ void GraphDraw::drawCross(QPointF pt, double w)
 
 void GraphDraw::drawDataSet(int id, int width)
 {
-    QList<QPointF> list = information->getDataList(id);
+    DataSetLod lod = information->getDataLod(id);
     DataStyle style = information->getDataStyle(id);
 
+    // the size of a pixel in data units is only constant in linear views, log ones draw every point
+    double pixelWidth = 0, pixelHeight = 0;
+    if(graphView.viewType() == ZeScaleType::LINEAR || graphView.viewType() == ZeScaleType::LINEAR_ORTHONORMAL)
+    {
+        pixelWidth = 1 / fabs(uniteX);
+        pixelHeight = 1 / fabs(uniteY);
+    }
+
+    QRectF visible(QPointF(graphView.getXmin(), graphView.getYmin()), QPointF(graphView.getXmax(), graphView.getYmax()));
 
     pen.setColor(style.color);
     painter.setPen(pen);
 
     if(style.drawLines)
     {
-        QPolygonF polygon;
         pen.setStyle(style.lineStyle);
         painter.setPen(pen);
-        painter.drawPolyline(polygon.fromList(list));
+        painter.drawPolyline(lod.getPolyline(visible, pixelWidth));
         pen.setStyle(Qt::SolidLine);
         painter.setPen(pen);
     }
@@ -142,23 +150,26 @@ void GraphDraw::drawDataSet(int id, int width)
 
     if(style.drawPoints)
     {
-        for(int i = 0 ; i < list.size() ; i++)
+        // markers closer than their radius cover each other, one per cell of that size is drawn
+        QPolygonF markers = lod.getMarkers(visible, width * pixelWidth, width * pixelHeight);
+
+        for(int i = 0 ; i < markers.size() ; i++)
             switch(style.pointStyle)
             {
             case Rhombus:
-                drawRhombus(list[i], width);
+                drawRhombus(markers[i], width);
                 break;
             case Disc:
-                drawDisc(list[i], width);
+                drawDisc(markers[i], width);
                 break;
             case Square:
-                drawSquare(list[i], width);
+                drawSquare(markers[i], width);
                 break;
             case Triangle:
-                drawTriangle(list[i], width);
+                drawTriangle(markers[i], width);
                 break;
             case Cross:
-                drawCross(list[i], width);
+                drawCross(markers[i], width);
                 break;
             }
     }
@@ -239,48 +250,40 @@ void GraphDraw::drawOneSequence(int i, int width)
      painter.setRenderHint(QPainter::Antialiasing, graphSettings.smoothing && !moving);
      pen.setWidth(width);
 
-     QPointF point;
-     double posX;
+     int nMin = seqs[0]->get_nMin();
+     int nStart = graphView.getXmin() > nMin ? qMin(trunc(graphView.getXmin()), MAX_SAVED_SEQ_VALS + 1.0) : nMin;
+     int nEnd = qMin(trunc(graphView.getXmax()), MAX_SAVED_SEQ_VALS + 0.0);
 
-     double viewXmin = graphView.viewRect().left();
-     double viewXmax = graphView.viewRect().right();
-
-     double Xmin = graphView.getXmin();
-     double Xmax = graphView.getXmax();
-
-     if(Xmin >  seqs[0]->get_nMin())
-         posX = viewXmin;
-     else posX = graphView.unitToView_x(seqs[0]->get_nMin());
-
-     double step = 1;
+     int step = 1;
 
      if(uniteX < 1)
          step = 5 * trunc(1/uniteX);
 
-
-     double result;
      bool ok = true;
-     int end = seqs[i]->getDrawsNum();
+     QVector<double> values;
+     QPolygonF points;
 
      ColorSaver *colorSaver = seqs[i]->getColorSaver();
 
-
-     for(int k = 0; k < end; k++)
+     for(int k = 0; k < seqs[i]->getDrawsNum(); k++)
      {
-         pen.setColor(colorSaver->getColor(k));
-         painter.setPen(pen);
+         // every visible term of this k-draw at once, drawn in a single call
+         values = seqs[i]->getSeqValues(nStart, nEnd, step, ok, k);
 
-         for(double pos = posX; pos < viewXmax; pos += step)
-         {
-             result = seqs[i]->getSeqValue(trunc(graphView.unitToView_x(pos)), ok, k);
+         if(!ok)
+             return;
 
-             if(!ok  || !std::isnormal(result))
-                 return;
+         points.clear();
 
-             point.setX(pos);
-             point.setY(result);
-             painter.drawPoint(point);
+         for(int j = 0 ; j < values.size() ; j++)
+         {
+             if(std::isfinite(values[j]))
+                 points << QPointF(graphView.unitToView_x(nStart + j * step), graphView.unitToView_y(values[j]));
          }
+
+         pen.setColor(colorSaver->getColor(k));
+         painter.setPen(pen);
+         painter.drawPoints(points);
      }
 }
 
@@ -35,6 +35,15 @@ MainGraph::MainGraph(Information *info) : GraphDraw(info)
 
     exprCalculator = new ExprCalculator(false, info->getFuncsList());
 
+    funcValuesWorker = new FuncValuesWorker(info->getFuncsList());
+    connect(funcValuesWorker, SIGNAL(curvesReady()), this, SLOT(updateFuncCurves()));
+    connect(info, SIGNAL(aboutToUpdate()), funcValuesWorker, SLOT(stop()));
+    funcValuesWorker->start();
+
+    curvesTiles = new CurvesTiles();
+    connect(curvesTiles, SIGNAL(tilesRendered()), this, SLOT(updateTiles()));
+    restyleTiles = retileCurves = true;
+
     selectedCurve.isSomethingSelected = false;
     cancelUpdateSignal = false;
     resaveTangent = animationUpdate = false;
@@ -108,6 +117,7 @@ MainGraph::MainGraph(Information *info) : GraphDraw(info)
 
 void MainGraph::reactivateSmoothing()
 {
+    restyleTiles = true;
     moving = recalculate = false;
     resaveGraph = true;
     update();
@@ -123,6 +133,7 @@ void MainGraph::updateGraph()
 {    
     if(!cancelUpdateSignal)
     {        
+        restyleTiles = true;
         resaveGraph = true;
         recalculate = true;
         update();
@@ -139,6 +150,24 @@ void MainGraph::updateData()
     update();
 }
 
+void MainGraph::updateFuncCurves()
+{
+    funcValuesWorker->getCurves(funcValuesSaver);
+    retileCurves = true;
+
+    if(mouseState.hovering && mouseState.funcType == FUNC_HOVER && mouseState.kPos >= funcValuesSaver->getFuncDrawsNum(mouseState.id))
+        mouseState.hovering = false;
+
+    resaveGraph = true;
+    update();
+}
+
+void MainGraph::updateTiles()
+{
+    resaveGraph = true;
+    update();
+}
+
 void MainGraph::addOtherWidgets()
 {
     QLabel *zoom1 = new QLabel();
@@ -528,7 +557,7 @@ void MainGraph::directPaint()
     if(recalculate)
     {
         recalculate = false;
-        funcValuesSaver->calculateAll(uniteX, uniteY, graphView);
+        funcValuesWorker->recalculate(uniteX, uniteY, graphView, graphSettings.distanceBetweenPoints);
         recalculateRegVals();
     }
     else if(recalculateRegs)
@@ -539,7 +568,7 @@ void MainGraph::directPaint()
 
     painter.translate(QPointF(centre.x, centre.y));
 
-    drawFunctions();
+    drawFunctionTiles();
     drawSequences();
     drawStraightLines();
     drawTangents();
@@ -631,7 +660,7 @@ void MainGraph::resaveImageBuffer()
     if(recalculate)
     {
         recalculate = false;
-        funcValuesSaver->calculateAll(uniteX, uniteY, graphView);
+        funcValuesWorker->recalculate(uniteX, uniteY, graphView, graphSettings.distanceBetweenPoints);
         recalculateRegVals();
     }
     else if(recalculateRegs)
@@ -642,7 +671,7 @@ void MainGraph::resaveImageBuffer()
 
     painter.translate(QPointF(centre.x, centre.y));
 
-    drawFunctions();
+    drawFunctionTiles();
     drawSequences();
     drawStraightLines();
     drawTangents();
@@ -652,6 +681,49 @@ void MainGraph::resaveImageBuffer()
     painter.end();
 }
 
+TilesContent MainGraph::getTilesContent()
+{
+    TilesContent content;
+
+    content.curves = funcValuesSaver->getCurves();
+    content.xMin = funcValuesSaver->getSampledStart();
+    content.xMax = funcValuesSaver->getSampledEnd();
+    content.calculationId = funcValuesSaver->getCalculationId();
+    content.thickness = graphSettings.curvesThickness;
+    content.smoothing = graphSettings.smoothing;
+
+    for(int func = 0 ; func < funcs.size() ; func++)
+    {
+        QList<QColor> colors;
+
+        if(funcs[func]->getDrawState())
+            for(int curve = 0 ; curve < funcValuesSaver->getFuncDrawsNum(func) ; curve++)
+                colors << funcs[func]->getColorSaver()->getColor(curve);
+
+        content.colors << colors;
+    }
+
+    return content;
+}
+
+void MainGraph::drawFunctionTiles()
+{
+    if(restyleTiles || retileCurves)
+    {
+        curvesTiles->setContent(getTilesContent(), restyleTiles);
+        restyleTiles = retileCurves = false;
+    }
+
+    painter.save();
+    painter.resetTransform();
+    painter.translate(QPointF(centre.x, centre.y));
+
+    curvesTiles->draw(painter, QRectF(-centre.x, -centre.y, graphWidth, graphHeight), uniteX, uniteY,
+                      moving ? dragDirection : QPoint());
+
+    painter.restore();
+}
+
 void MainGraph::updateCenterPosAndScaling()
 {
     uniteY = graphHeight / (graphView.viewRect().height());
@@ -994,6 +1066,7 @@ void MainGraph::mouseMoveEvent(QMouseEvent *event)
             double dy = (mouseY - lastPosSouris.y)/uniteY;
 
             graphView.translateView(QPointF(dx, dy));
+            dragDirection = QPoint(dx > 0 ? 1 : (dx < 0 ? -1 : 0), dy < 0 ? 1 : (dy > 0 ? -1 : 0)); // where new tiles appear
 
             cancelUpdateSignal = true;
             information->setRange(graphView);
@@ -1002,7 +1075,7 @@ void MainGraph::mouseMoveEvent(QMouseEvent *event)
 
             if(dx != 0)
             {
-                funcValuesSaver->move(graphView);
+                funcValuesWorker->move(graphView);
                 moveSavedRegsValues();
             }
 
@@ -1097,46 +1170,33 @@ void MainGraph::mouseMoveWithActiveSelection(double x, double y)
 
 void MainGraph::mouseFuncHoverTest(double x, double y)
 {
-    double calcY = 0;   
-    double k = 0;
-    int draw;
-    double rangeLimit;
-    Range kRange;
+    // hit tested against the sampled curves: a binary search on their abscissas, no evaluation
+    QPointF pt(graphView.unitToView_x(x), graphView.unitToView_y(y));
+    QList< QList<CurveBuffer> > curves = funcValuesSaver->getCurves();
+    double radius = graphSettings.curvesThickness + 1;
 
-    for(short i = 0; i < funcs.size(); i++)
+    for(short i = 0; i < funcs.size() && i < curves.size(); i++)
     {
         if(!funcs[i]->getDrawState())
             continue;
 
-        kRange = funcs[i]->getParametricRange();
-        k = kRange.start;
-        draw = 0;
-        rangeLimit = kRange.start + kRange.step * PAR_DRAW_LIMIT;
-
-        while(k <= kRange.end && k < rangeLimit )
+        for(short draw = 0 ; draw < curves[i].size() ; draw++)
         {
-            calcY = funcs[i]->getFuncValue(x, k);
+            if(selectedCurve.isSomethingSelected && selectedCurve.funcType == FUNCTION && draw == selectedCurve.kPos && i == selectedCurve.id)
+                continue;
 
-            if(!(std::isnan(calcY) || std::isinf(calcY)))
+            if(curves[i][draw].distanceTo(pt, uniteX, uniteY, radius) < radius)
             {
-                if(!(selectedCurve.isSomethingSelected && selectedCurve.funcType == FUNCTION && draw == selectedCurve.kPos && i == selectedCurve.id))
-                {
-                    if((fabs(calcY - y) * uniteY) < graphSettings.curvesThickness + 1)
-                    {
-                        mouseState.hovering = true;
-                        mouseState.tangentHovering = false;
-                        mouseState.funcType = FUNC_HOVER;
-                        mouseState.isParametric = funcs[i]->isFuncParametric();
-                        mouseState.kPos = draw;
-                        mouseState.id = i;
-                        recalculate = false;
-
-                        return;
-                    }
-                }
+                mouseState.hovering = true;
+                mouseState.tangentHovering = false;
+                mouseState.funcType = FUNC_HOVER;
+                mouseState.isParametric = funcs[i]->isFuncParametric();
+                mouseState.kPos = draw;
+                mouseState.id = i;
+                recalculate = false;
+
+                return;
             }
-            k += kRange.step;
-            draw++;
         }
     }
 }
@@ -1501,6 +1561,8 @@ void MainGraph::stop_Y_Zoom()
 
 MainGraph::~MainGraph()
 {
+    delete funcValuesWorker;
+    delete curvesTiles;
     delete savedGraph;
     delete exprCalculator;
 }
@@ -25,6 +25,8 @@
 #define MainGraph_H
 
 #include "graphdraw.h"
+#include "Calculus/funcvaluesworker.h"
+#include "GraphDraw/curvestiles.h"
 
 #define FUNC_HOVER 0
 #define SEQ_HOVER 1
@@ -76,6 +78,8 @@ public slots:
     void updateParEq();
     void updateGraph();
     void updateData();
+    void updateFuncCurves();
+    void updateTiles();
 
 protected slots:
 
@@ -103,6 +107,8 @@ protected:
     void resaveImageBuffer();    
     void addTangentToBuffer();
     void drawHoveringConsequence();  
+    void drawFunctionTiles();
+    TilesContent getTilesContent();
 
     void newWindowSize();
     void directPaint();
@@ -121,6 +127,10 @@ protected:
     void checkIfActiveSelectionConflicts();
 
     ExprCalculator *exprCalculator;
+    FuncValuesWorker *funcValuesWorker; // computes the curves drawn from funcValuesSaver
+    CurvesTiles *curvesTiles;
+    bool restyleTiles, retileCurves;
+    QPoint dragDirection;
     Point lastPosSouris, pointPx, pointUnit;
     QSlider *hSlider, *vSlider;
     QLineEdit *lineX, *lineY;
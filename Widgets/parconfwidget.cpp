@@ -37,7 +37,6 @@ ParConfWidget::ParConfWidget(QChar parName, bool withAnimateButton, bool withKee
     widgetsLayout->setSpacing(3);
     addConfWidgets(widgetsLayout);
 
-    startTree = endTree = stepTree = NULL;
     kState = valid = isStepGood = isEndGood = isStartGood = false;
 
     QColor color;
@@ -131,7 +130,7 @@ void ParConfWidget::checkExprForK(QString expr)
     kState = is_k_present;
 }
 
-void ParConfWidget::updateTreeWithExpr(QString &lastExpr, QLineEdit *line, FastTree **treePointerAdress, bool &isExprGood)
+void ParConfWidget::updateCodeWithExpr(QString &lastExpr, QLineEdit *line, ByteCode *code, bool &isExprGood)
 {
     if(lastExpr != line->text())
     {
@@ -139,12 +138,7 @@ void ParConfWidget::updateTreeWithExpr(QString &lastExpr, QLineEdit *line, FastT
         isExprGood = calculator->checkCalledFuncsValidity(lastExpr);
 
         if(isExprGood)
-        {
-            if(*treePointerAdress != NULL)
-                treeCreator.deleteFastTree(*treePointerAdress);
-
-            *treePointerAdress = treeCreator.getTreeFromExpr(lastExpr, isExprGood);
-        }
+            *code = treeCreator.getByteCodeFromExpr(lastExpr, isExprGood);
 
         if(isExprGood)
             line->setPalette(validPalette);
@@ -169,9 +163,9 @@ void ParConfWidget::resetPaletteForEndLineEdit()
 
 void ParConfWidget::validate()
 {
-    updateTreeWithExpr(lastStartExpr, start, &startTree, isStartGood);
-    updateTreeWithExpr(lastEndExpr, end, &endTree, isEndGood);
-    updateTreeWithExpr(lastStepExpr, step, &stepTree, isStepGood);
+    updateCodeWithExpr(lastStartExpr, start, &startCode, isStartGood);
+    updateCodeWithExpr(lastEndExpr, end, &endCode, isEndGood);
+    updateCodeWithExpr(lastStepExpr, step, &stepCode, isStepGood);
 
     valid = isStartGood && isStepGood && isEndGood;
 }
@@ -206,21 +200,14 @@ Range ParConfWidget::getRange(double k)
     Range range;
     calculator->setK(k);
 
-    range.start = calculator->calculateFromTree(startTree);
-    range.step = calculator->calculateFromTree(stepTree);
-    range.end = calculator->calculateFromTree(endTree);
+    range.start = calculator->calculateFromByteCode(startCode);
+    range.step = calculator->calculateFromByteCode(stepCode);
+    range.end = calculator->calculateFromByteCode(endCode);
 
     return range;
 }
 
 ParConfWidget::~ParConfWidget()
 {
-    if(stepTree != NULL)
-        treeCreator.deleteFastTree(stepTree);
-    if(endTree != NULL)
-        treeCreator.deleteFastTree(endTree);
-    if(startTree != NULL)
-        treeCreator.deleteFastTree(startTree);
-
     delete calculator;
 }
@@ -61,13 +61,13 @@ protected slots:
 
 protected:
     void addConfWidgets(QHBoxLayout *layout);
-    void updateTreeWithExpr(QString &lastExpr, QLineEdit *line, FastTree **treePointerAdress, bool &isExprGood);
+    void updateCodeWithExpr(QString &lastExpr, QLineEdit *line, ByteCode *code, bool &isExprGood);
 
     QLineEdit *start, *step, *end;
     QCheckBox *animate, *keepTracks;
     TreeCreator treeCreator;
     ExprCalculator *calculator;
-    FastTree *startTree, *stepTree, *endTree;
+    ByteCode startCode, stepCode, endCode;
     QString lastStartExpr, lastStepExpr, lastEndExpr;
     QPalette validPalette, invalidPalette, neutralPalette;
     Range defaultRange;
@@ -29,7 +29,6 @@ ParEqWidget::ParEqWidget(int num, QList<FuncCalculator*> list, QColor col) : tre
     index = num;
     funcCalcs = list;
     createWidgets(col);
-    xTree = yTree = NULL;   
     isParametric = valid = is_t_range_parametric = false;
     playState = false;
     blockAnimation = false;
@@ -254,11 +253,15 @@ void ParEqWidget::addTConfWidgets()
 
      calculator->setK(k);
 
+     double xy[2];
+
      for(int i = 0 ; i < end ; i++)
      {
+         calculator->calculateOutputsFromByteCode(xyCode, t, xy);
+
          vals.tValues << t;
-         vals.xValues << calculator->calculateFromTree(xTree, t);
-         vals.yValues << calculator->calculateFromTree(yTree, t);
+         vals.xValues << xy[0];
+         vals.yValues << xy[1];
 
          t += t_range.step;
      }
@@ -269,10 +272,12 @@ void ParEqWidget::addTConfWidgets()
  Point ParEqWidget::getPoint(double t, double k)
  {
      Point pt;
+     double xy[2];
 
      calculator->setK(k);
-     pt.x = calculator->calculateFromTree(xTree, t);
-     pt.y = calculator->calculateFromTree(yTree, t);
+     calculator->calculateOutputsFromByteCode(xyCode, t, xy);
+     pt.x = xy[0];
+     pt.y = xy[1];
 
      return pt;
  }
@@ -431,6 +436,7 @@ void ParEqWidget::apply()
     updateKRange();
     checkXline();
     checkYline();
+    updateXYCode();
 
     tWidget->validate();
     updateTRange(kRange.start);
@@ -468,10 +474,7 @@ void ParEqWidget::checkXline()
 {
     if(xExpr != xLine->text())
     {
-        if(xTree != NULL)
-            treeCreator.deleteFastTree(xTree);
-
-        xTree = treeCreator.getTreeFromExpr(xLine->text(), isXExprGood);
+        treeCreator.getByteCodeFromExpr(xLine->text(), isXExprGood);
 
         if(isXExprGood)
             xLine->setPalette(validPalette);
@@ -486,10 +489,7 @@ void ParEqWidget::checkYline()
 {
     if(yExpr != yLine->text())
     {
-        if(yTree != NULL)
-            treeCreator.deleteFastTree(yTree);
-
-        yTree = treeCreator.getTreeFromExpr(yLine->text(), isYExprGood);
+        treeCreator.getByteCodeFromExpr(yLine->text(), isYExprGood);
 
         if(isYExprGood)
             yLine->setPalette(validPalette);
@@ -500,6 +500,15 @@ void ParEqWidget::checkYline()
     }
 }
 
+void ParEqWidget::updateXYCode()
+{
+    if(hasSomethingChanged && isXExprGood && isYExprGood)
+    {
+        bool ok;
+        xyCode = treeCreator.getByteCodeFromExprs(QStringList() << xExpr << yExpr, ok);
+    }
+}
+
 void ParEqWidget::updateTRange(double k)
 {    
     if(!areIdentical(tRange, tWidget->getRange(k)))
@@ -554,7 +563,7 @@ ColorSaver* ParEqWidget::getColorSaver()
 void ParEqWidget::calculatePointsList()
 {
     int numDraws = 1, end;
-    double k = kRange.start, t = 0, tStep = 0, tRatio = 1;
+    double k = kRange.start, t = 0, tStep = 0, tRatio = 1, xy[2];
 
     if(tWidget->isAnimateChecked() && ratio < 1)
         tRatio = ratio;
@@ -581,8 +590,9 @@ void ParEqWidget::calculatePointsList()
 
         for(int i = 0 ; i < end ; i++)
         {
-            point.x = calculator->calculateFromTree(xTree, t);
-            point.y = calculator->calculateFromTree(yTree, t);
+            calculator->calculateOutputsFromByteCode(xyCode, t, xy);
+            point.x = xy[0];
+            point.y = xy[1];
 
             list << point;
 
@@ -704,11 +714,13 @@ void ParEqWidget::nextFrameKchecked()
     double t = tRange.start;
     int end = trunc((tRange.end - tRange.start)/tRange.step)+ 1;
     Point point;
+    double xy[2];
 
     for(int i = 0 ; i < end ; i++)
     {
-        point.x = calculator->calculateFromTree(xTree, t);
-        point.y = calculator->calculateFromTree(yTree, t);
+        calculator->calculateOutputsFromByteCode(xyCode, t, xy);
+        point.x = xy[0];
+        point.y = xy[1];
 
         currentPolygon[0] << point;
 
@@ -775,9 +787,6 @@ void ParEqWidget::playButtonClicked()
 
 ParEqWidget::~ParEqWidget()
 {
-    if(xTree != NULL)
-        treeCreator.deleteFastTree(xTree);
-    if(yTree != NULL)
-        treeCreator.deleteFastTree(yTree);
+    delete calculator;
 }
 
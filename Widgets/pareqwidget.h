@@ -99,6 +99,7 @@ protected:
 
     void checkXline();
     void checkYline();
+    void updateXYCode();
     void updateTRange(double k);
     void updateKRange();
 
@@ -133,7 +134,7 @@ protected:
     QList<FuncCalculator*> funcCalcs;
     QString xExpr, yExpr;
     Range tRange, kRange;
-    FastTree *xTree, *yTree;
+    ByteCode xyCode; // x(t) and y(t) compiled together so they share their common subexpressions
 
 
 };
@@ -235,8 +235,8 @@ void TangentWidget::calculateTangentPoints(double xUnit, double yUnit)
     raty = (yUnit/xUnit+1)/2;
     ratx = (xUnit/yUnit+1)/2;
 
-    a = funcCalculators[funcID]->getDerivativeValue(pos, k);
-    double b = -pos*a + funcCalculators[funcID]->getFuncValue(pos, k);
+    double y = funcCalculators[funcID]->getFuncValueAndDerivative(pos, k, a);
+    double b = -pos*a + y;
 
     slopeLineEdit->setText(QString::number(a, 'g', NUM_PREC));
     ordinateAtOriginLineEdit->setText(QString::number(b, 'g', NUM_PREC));
@@ -244,7 +244,7 @@ void TangentWidget::calculateTangentPoints(double xUnit, double yUnit)
     double d = 0.5 * lenght * sqrt(1/(a*a*raty*raty + ratx*ratx));
 
     tangentPoints.center.x = pos;
-    tangentPoints.center.y = funcCalculators[funcID]->getFuncValue(pos, k);
+    tangentPoints.center.y = y;
 
     tangentPoints.right.x = pos + d;
     tangentPoints.right.y = a*tangentPoints.right.x + b;
@@ -191,6 +191,7 @@ void MathObjectsInput::setInfoClass(Information *info)
 
 void MathObjectsInput::draw()
 {    
+    information->emitAboutToUpdate();
     validateFunctions();
     validateSequences();
     validateLines();
@@ -5,7 +5,7 @@
 #-------------------------------------------------
 
 
-QT += widgets printsupport webkitwidgets
+QT += widgets printsupport webkitwidgets concurrent
 
 TARGET = ZeGrapher
 TEMPLATE = app
@@ -50,16 +50,23 @@ SOURCES += \
     DataPlot/rowactionswidget.cpp \
     DataPlot/datawindow.cpp \    
     DataPlot/datatable.cpp \
+    DataPlot/datatablemodel.cpp \
     DataPlot/columnselectorwidget.cpp \
     DataPlot/columnactionswidget.cpp \
     Calculus/treecreator.cpp \
+    Calculus/bytecodeevaluator.cpp \
+    Calculus/valuescache.cpp \
+    Calculus/curvebuffer.cpp \
     Calculus/seqcalculator.cpp \
     Calculus/funcvaluessaver.cpp \
+    Calculus/funcvaluesworker.cpp \
     Calculus/funccalculator.cpp \
     Calculus/exprcalculator.cpp \
     Calculus/colorsaver.cpp \
     Widgets/datawidget.cpp \
     DataPlot/csvhandler.cpp \
+    DataPlot/csvparser.cpp \
+    DataPlot/datafile.cpp \
     Calculus/polynomial.cpp \
     Calculus/polynomialregression.cpp \
     Calculus/regression.cpp \
@@ -74,7 +81,9 @@ SOURCES += \
     Windows/values.cpp \
     Windows/updatecheck.cpp \
     Windows/mainwindow.cpp \
-    GraphDraw/graphview.cpp
+    GraphDraw/graphview.cpp \
+    GraphDraw/curvestiles.cpp \
+    GraphDraw/datasetlod.cpp
 
 HEADERS  += \
     information.h \
@@ -106,18 +115,25 @@ HEADERS  += \
     DataPlot/rowactionswidget.h \
     DataPlot/datawindow.h \   
     DataPlot/datatable.h \
+    DataPlot/datatablemodel.h \
     DataPlot/columnselectorwidget.h \
     DataPlot/columnactionswidget.h \
     Calculus/treecreator.h \
+    Calculus/bytecodeevaluator.h \
+    Calculus/valuescache.h \
+    Calculus/curvebuffer.h \
     Calculus/seqcolorssaver.h \
     Calculus/seqcalculator.h \
     Calculus/funcvaluessaver.h \
+    Calculus/funcvaluesworker.h \
     Calculus/funccalculator.h \
     Calculus/exprcalculator.h \
     Calculus/colorsaver.h \
     Calculus/calculusdefines.h \
     Widgets/datawidget.h \
     DataPlot/csvhandler.h \
+    DataPlot/csvparser.h \
+    DataPlot/datafile.h \
     Calculus/polynomial.h \
     Calculus/polynomialregression.h \
     Calculus/regression.h \
@@ -133,8 +149,18 @@ HEADERS  += \
     Windows/updatecheck.h \
     Windows/mainwindow.h \
     GraphDraw/graphview.h \
+    GraphDraw/curvestiles.h \
+    GraphDraw/datasetlod.h \
     structures.h
 
+# Compiles expressions to native x86-64 code (Linux and macOS), enabled with: qmake CONFIG+=jit
+# Benchmarks/jitbenchmark.pro compares it to the bytecode interpreter.
+jit {
+    DEFINES += ZEGRAPHER_JIT
+    SOURCES += Calculus/jitcompiler.cpp
+    HEADERS += Calculus/jitcompiler.h
+}
+
 
 FORMS    += \
     Windows/about.ui \
@@ -47,6 +47,7 @@ void Information::emitDataUpdate()
 void Information::addDataList()
 {
     data << QList<QPointF>();
+    dataLods << DataSetLod();
 
     DataStyle style;
     dataStyle << style;
@@ -55,6 +56,7 @@ void Information::addDataList()
 void Information::removeDataList(int index)
 {
     data.removeAt(index);
+    dataLods.removeAt(index);
     dataStyle.removeAt(index);
     emit updateOccured();
 }
@@ -68,6 +70,7 @@ void Information::setDataStyle(int index, DataStyle style)
 void Information::setData(int index, QList<QPointF> list)
 {
     data[index] = list;
+    dataLods[index] = DataSetLod(list);
     emit dataUpdated();
 }
 
@@ -81,6 +84,11 @@ QList<QPointF> Information::getDataList(int index)
     return data[index];
 }
 
+DataSetLod Information::getDataLod(int index)
+{
+    return dataLods[index];
+}
+
 DataStyle Information::getDataStyle(int index)
 {
     return dataStyle[index];
@@ -203,6 +211,11 @@ void Information::setGraphSettings(GraphSettings opt)
     emit newGraphSettings();
 }
 
+void Information::emitAboutToUpdate()
+{
+    emit aboutToUpdate();
+}
+
 void Information::emitUpdateSignal()
 {
     emit updateOccured();
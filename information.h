@@ -30,6 +30,7 @@
 #include "Widgets/tangentwidget.h"
 #include "Calculus/colorsaver.h"
 #include "Calculus/regressionvaluessaver.h"
+#include "GraphDraw/datasetlod.h"
 
 class Information: public QObject
 {
@@ -48,6 +49,7 @@ public:
 
     int getDataListsCount();
     QList<QPointF> getDataList(int index);
+    DataSetLod getDataLod(int index); // what the data set is drawn from
     DataStyle getDataStyle(int index);
 
     void addDataRegression(Regression *reg);
@@ -79,6 +81,7 @@ public:
     bool isOrthonormal();
 
 public slots:
+    void emitAboutToUpdate();
     void emitUpdateSignal();
     void emitDataUpdate();
     void emitDrawStateUpdate();
@@ -88,6 +91,7 @@ signals:
 
     void dataUpdated();
     void gridStateChange();
+    void aboutToUpdate(); // the math objects are going to be modified, whatever computes with them must stop
     void updateOccured();
     void drawStateUpdateOccured();
     void animationUpdate();
@@ -105,6 +109,7 @@ public slots:
 protected:
 
     QList<QList<QPointF> > data;
+    QList<DataSetLod> dataLods;
     QList<DataStyle> dataStyle;
 
     QList<Regression*> regressions;
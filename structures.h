@@ -72,12 +72,30 @@ struct Point
     }
 };
 
-struct FastTree
+struct FastTree // node of an expression tree, stored in TreeCreator's nodes arena
 {
     short type;
-    double *value;
-    FastTree *left;
-    FastTree *right;
+    double value; // only meaningful for NUMBER nodes
+    int left, right; // indexes of the children in the arena, NO_CHILD when there is none
+};
+
+#define NO_CHILD -1
+
+struct ByteCodeInstr
+{
+    short type;
+    double value; // only meaningful for NUMBER instructions
+};
+
+typedef void (*NativeByteCode)(double *stack, double var, double k); // see JitCompiler
+
+struct ByteCode
+{
+    QVector<ByteCodeInstr> instructions; // FastTree flattened in postfix order
+    int stackSize = 0;
+    int tempsCount = 0; // subexpressions computed once and reloaded, see TreeCreator::compileFastTrees
+    int outputsCount = 0; // one per compiled tree, left in order at the bottom of the stack
+    NativeByteCode native = NULL; // machine code of the program when built with CONFIG+=jit, runs instead
 };
 
 